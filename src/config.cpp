@@ -17,6 +17,7 @@
  *************************************************************************/
 
 #include "config.hpp"
+#include "layout_compositor.hpp"
 #include "ui/durchblick.hpp"
 #include "ui/new_multiview_dialog.hpp"
 #include "ui/manage_multiviews_dialog.hpp"
@@ -30,6 +31,7 @@
 #include <obs-frontend-api.h>
 #include <obs-module.h>
 #include <util/platform.h>
+#include <util/profiler.hpp>
 #include <util/util.hpp>
 
 #if !defined(_WIN32) && !defined(__APPLE__)
@@ -151,6 +153,7 @@ static void event_callback(enum obs_frontend_event event, void*)
             if (it.value() && it.value()->window)
                 it.value()->window->GetLayout()->Clear();
         }
+        LayoutCompositor::ClearAll();
     } else if (event == OBS_FRONTEND_EVENT_SCENE_COLLECTION_CHANGED) {
         // Only reload if initial load is done (not during startup)
         if (initialLoadDone) {
@@ -183,6 +186,7 @@ void RemoveCallbacks()
 
 void Load()
 {
+    ProfileScope("Config::Load");
     blog(LOG_INFO, "[Command Center] Config::Load() called");
     isLoading = true;
     auto cfg = LoadLayoutsForCurrentSceneCollection();
@@ -236,10 +240,14 @@ void Load()
 
     isLoading = false;
     blog(LOG_INFO, "[Command Center] Config::Load() finished");
+
+    // Multiview sources were created before the multiviews they show existed
+    LayoutCompositor::RefreshAll();
 }
 
 void Save()
 {
+    ProfileScope("Config::Save");
     if (isLoading) {
         blog(LOG_WARNING, "[Command Center] Config::Save() called during load, ignoring to prevent overwriting loaded data");
         return;
@@ -254,8 +262,15 @@ void Save()
     QJsonObject multiviewsObj {};
     for (auto it = multiviews.begin(); it != multiviews.end(); ++it) {
         auto* mv = it.value();
-        if (!mv->isPersistent)
-            continue; // Don't save non-persistent multiviews
+        if (!mv->isPersistent) {
+            // Don't save non-persistent multiviews, but keep their saved layout current
+            // for multiview sources and wall tiles
+            if (mv->window) {
+                QJsonObject layout {};
+                mv->window->Save(layout);
+            }
+            continue;
+        }
 
         QJsonObject mvData {};
         mvData["name"] = mv->name;
@@ -293,6 +308,8 @@ void Save()
     } else {
         berr("Couldn't write config to %s", path.Get());
     }
+
+    LayoutCompositor::RefreshAll();
 }
 
 void Cleanup()
@@ -306,10 +323,18 @@ void Cleanup()
     isShuttingDown = true;
     cleanedUp = true;
 
+    // Logged before anything is cleared, wall tiles include their shared compositor
+    for (auto* mv : std::as_const(multiviews)) {
+        if (mv->window)
+            binfo("Resources of multiview '%s': %s", qt_to_utf8(mv->name), qt_to_utf8(mv->window->Resources().Summary()));
+    }
+
+    // Multiview sources would otherwise keep the sources of their layouts alive
+    LayoutCompositor::Shutdown();
+
     // Clean up multiviews
-    for (auto it = multiviews.begin(); it != multiviews.end(); ++it) {
+    for (auto it = multiviews.begin(); it != multiviews.end(); ++it)
         delete it.value();
-    }
     multiviews.clear();
 
     // Note: db might point to a multiview window, so don't delete it here
@@ -372,6 +397,15 @@ QList<QString> GetMultiviewIds()
     return multiviews.keys();
 }
 
+QJsonObject GetLayoutData(const QString& id)
+{
+    // Config::Save() just serialized every window, don't do it again for each compositor
+    auto* mv = GetMultiview(id);
+    if (mv && mv->window)
+        return mv->window->SavedLayout();
+    return {};
+}
+
 void UpdateToolsMenu()
 {
     if (!toolsMenu)
@@ -58,6 +58,8 @@ extern void RemoveMultiview(const QString& id);
 extern MultiviewInstance* GetMultiview(const QString& id);
 extern MultiviewInstance* GetMultiviewByWindow(Durchblick* window);
 extern QList<QString> GetMultiviewIds();
+/// Layout data of a multiview as of its last save or load, empty if there is no such multiview
+extern QJsonObject GetLayoutData(const QString& id);
 extern void UpdateToolsMenu();
 extern void ShowNewMultiviewDialog();
 extern void ShowManageMultiviewsDialog();
@@ -18,6 +18,7 @@
 
 #include "config.hpp"
 #include "items/registry.hpp"
+#include "layout_compositor.hpp"
 #include "ui/durchblick.hpp"
 #include "util/util.h"
 #include <QAction>
@@ -45,6 +46,7 @@ bool obs_module_load()
     binfo("Loading v%s-%s (%s) build time %s", PLUGIN_VERSION, GIT_BRANCH, GIT_COMMIT_HASH, BUILD_TIME);
 
     Registry::RegisterCustomWidgetProcedure();
+    LayoutCompositor::Register();
 
     // Create Command Center menu action and submenu
     QAction* action = static_cast<QAction*>(obs_frontend_add_tools_menu_qaction(T_MENU_DURCHBLICK));
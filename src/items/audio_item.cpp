@@ -0,0 +1,117 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "audio_item.hpp"
+#include "source_item.hpp"
+#include <algorithm>
+
+AudioItem::AudioItem(Layout* parent, std::unique_ptr<AudioConsumer> consumer, int x, int y, int w, int h)
+    : LayoutItem(parent, x, y, w, h)
+    , m_consumer(std::move(consumer))
+{
+    m_tap = std::make_unique<AudioTap>(m_consumer.get());
+}
+
+AudioItem::~AudioItem()
+{
+    m_removed_signal.Disconnect();
+    m_tap = nullptr;
+}
+
+void AudioItem::OBSSourceRemoved(void* data, calldata_t*)
+{
+    // The tap is safe to detach from any thread
+    static_cast<AudioItem*>(data)->m_tap->SetSource(nullptr);
+}
+
+void AudioItem::SetSource(obs_source_t* src)
+{
+    m_removed_signal.Disconnect();
+    m_tap->SetSource(src);
+
+    OBSSource label;
+    if (src) {
+        m_removed_signal.Connect(obs_source_get_signal_handler(src), "remove", AudioItem::OBSSourceRemoved, this);
+        label = CreateLabel(obs_source_get_name(src), 400, 1);
+    }
+    std::lock_guard<std::mutex> lock(m_name_mutex);
+    m_name_label = label;
+}
+
+void AudioItem::DrawLabel(obs_source_t* label, float x, float y, float cx, float cy)
+{
+    auto lw = obs_source_get_width(label);
+    auto lh = obs_source_get_height(label);
+    if (lw == 0 || lh == 0)
+        return;
+    float scale = std::min(cx / lw, cy / lh);
+    gs_matrix_push();
+    gs_matrix_translate3f(x + (cx - lw * scale) / 2, y + (cy - lh * scale) / 2, 0);
+    gs_matrix_scale3f(scale, scale, 1);
+    obs_source_video_render(label);
+    gs_matrix_pop();
+}
+
+void AudioItem::DrawName(float x, float y, float cx, float cy)
+{
+    std::lock_guard<std::mutex> lock(m_name_mutex);
+    if (m_name_label)
+        DrawLabel(m_name_label, x, y, cx, cy);
+}
+
+void AudioItem::AddAudioSources(QComboBox* combo)
+{
+    QStringList names;
+    obs_enum_sources([](void* d, obs_source_t* src) -> bool {
+        if (obs_source_get_output_flags(src) & OBS_SOURCE_AUDIO)
+            static_cast<QStringList*>(d)->append(utf8_to_qt(obs_source_get_name(src)));
+        return true;
+    },
+        &names);
+    names.sort();
+    combo->addItems(names);
+}
+
+void AudioItem::WriteToJson(QJsonObject& Obj)
+{
+    LayoutItem::WriteToJson(Obj);
+    if (auto src = m_tap->Source())
+        Obj["source"] = utf8_to_qt(obs_source_get_name(src));
+}
+
+void AudioItem::ReadFromJson(QJsonObject const& Obj)
+{
+    LayoutItem::ReadFromJson(Obj);
+
+    QString source_name = Obj["source"].toString();
+    if (source_name.isEmpty())
+        return;
+    OBSSourceAutoRelease src = obs_get_source_by_name(qt_to_utf8(source_name));
+    if (src)
+        SetSource(src);
+    else
+        bwarn("Source '%s' for %s not found during load", qt_to_utf8(source_name), metaObject()->className());
+}
+
+void AudioItem::AccountResources(ResourceUsage& usage)
+{
+    LayoutItem::AccountResources(usage);
+    if (m_tap->Source())
+        usage.audio_taps++;
+    std::lock_guard<std::mutex> lock(m_name_mutex);
+    usage.AddLabel(m_name_label);
+}
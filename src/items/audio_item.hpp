@@ -0,0 +1,64 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+
+#pragma once
+
+#include "../util/audio_tap.hpp"
+#include "item.hpp"
+#include <QComboBox>
+#include <memory>
+#include <mutex>
+#include <obs.hpp>
+
+// Base of items that analyze the audio of one source on a worker thread.
+// Owns the consumer and the tap feeding it, the consumer has to outlive the
+// tap's worker, so both live here and are torn down in the right order.
+class AudioItem : public LayoutItem {
+    Q_OBJECT
+    std::unique_ptr<AudioConsumer> m_consumer;
+    std::unique_ptr<AudioTap> m_tap;
+    OBSSignal m_removed_signal;
+    std::mutex m_name_mutex;
+    OBSSource m_name_label; // Replaced on the UI thread when the source changes
+
+    static void OBSSourceRemoved(void* data, calldata_t* params);
+
+protected:
+    /// Graphics thread, draws the label centered and scaled to fit into the rectangle
+    static void DrawLabel(obs_source_t* label, float x, float y, float cx, float cy);
+
+    /// Graphics thread, name of the source centered in the rectangle
+    void DrawName(float x, float y, float cx, float cy);
+
+    /// Adds all sources with audio, sorted by name
+    static void AddAudioSources(QComboBox* combo);
+
+public:
+    AudioItem(Layout* parent, std::unique_ptr<AudioConsumer> consumer, int x, int y, int w = 1, int h = 1);
+    ~AudioItem();
+
+    AudioConsumer* Consumer() const { return m_consumer.get(); }
+
+    /// UI thread, nullptr detaches
+    void SetSource(obs_source_t* src);
+    OBSSource GetSource() { return m_tap->Source(); }
+
+    void WriteToJson(QJsonObject& Obj) override;
+    void ReadFromJson(QJsonObject const& Obj) override;
+    void AccountResources(ResourceUsage& usage) override;
+};
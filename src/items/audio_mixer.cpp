@@ -17,6 +17,21 @@
  *************************************************************************/
 
 #include "audio_mixer.hpp"
+#include "../config.hpp"
+#include "../layout.hpp"
+
+AudioMixerItem::AudioMixerItem(Layout* parent, int x, int y, int w, int h)
+    : LayoutItem(parent, x, y, w, h)
+{
+    m_mixer = std::make_unique<AudioMixerRenderer>(this);
+
+    m_toggle_compact = new QAction(T_MIXER_COMPACT, this);
+    m_toggle_compact->setCheckable(true);
+    connect(m_toggle_compact, &QAction::toggled, this, [this](bool compact) {
+        m_mixer->SetDensity(compact ? AudioMixerRenderer::Compact : AudioMixerRenderer::Expanded);
+        Config::Save();
+    });
+}
 
 QWidget* AudioMixerItem::GetConfigWidget()
 {
@@ -32,17 +47,30 @@ void AudioMixerItem::LoadConfigFromWidget(QWidget* w)
 void AudioMixerItem::Render(const DurchblickItemConfig& cfg)
 {
     LayoutItem::Render(cfg);
-    m_mixer->Render(cfg.scale, 1, 1);
+    m_mixer->Render(m_layout->Meters(), cfg.scale, 1, 1);
 }
 
 void AudioMixerItem::WriteToJson(QJsonObject& Obj)
 {
     LayoutItem::WriteToJson(Obj);
+    Obj["compact"] = m_toggle_compact->isChecked();
 }
 
 void AudioMixerItem::ReadFromJson(const QJsonObject& Obj)
 {
     LayoutItem::ReadFromJson(Obj);
+    bool compact = Obj["compact"].toBool();
+    m_toggle_compact->blockSignals(true);
+    m_toggle_compact->setChecked(compact);
+    m_toggle_compact->blockSignals(false);
+    m_mixer->SetDensity(compact ? AudioMixerRenderer::Compact : AudioMixerRenderer::Expanded);
+}
+
+void AudioMixerItem::ContextMenu(QMenu& m)
+{
+    // Picks up sources that were hidden or shown in the OBS mixer since the last signal
+    m_mixer->RecheckHidden();
+    m.addAction(m_toggle_compact);
 }
 
 void AudioMixerItem::Update(const DurchblickItemConfig& cfg)
@@ -51,6 +79,13 @@ void AudioMixerItem::Update(const DurchblickItemConfig& cfg)
     m_mixer->Update(cfg);
 }
 
+void AudioMixerItem::AccountResources(ResourceUsage& usage)
+{
+    LayoutItem::AccountResources(usage);
+    if (m_mixer)
+        m_mixer->AccountResources(usage);
+}
+
 void AudioMixerItem::MouseEvent(const MouseData& e, const DurchblickItemConfig& cfg)
 {
     LayoutItem::MouseEvent(e, cfg);
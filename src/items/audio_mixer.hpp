@@ -52,13 +52,10 @@ class AudioMixerItem : public LayoutItem {
     Q_OBJECT
     bool m_program { false };
     std::unique_ptr<AudioMixerRenderer> m_mixer {};
+    QAction* m_toggle_compact {};
 
 public:
-    AudioMixerItem(Layout* parent, int x, int y, int w = 1, int h = 1)
-        : LayoutItem(parent, x, y, w, h)
-    {
-        m_mixer = std::make_unique<AudioMixerRenderer>(this);
-    }
+    AudioMixerItem(Layout* parent, int x, int y, int w = 1, int h = 1);
 
     ~AudioMixerItem() = default;
     QWidget* GetConfigWidget() override;
@@ -68,8 +65,9 @@ public:
     void WriteToJson(QJsonObject& Obj) override;
     void ReadFromJson(QJsonObject const& Obj) override;
 
-    void ContextMenu(QMenu&) override { }
+    void ContextMenu(QMenu&) override;
     virtual void Update(DurchblickItemConfig const& cfg) override;
 
     void MouseEvent(MouseData const& e, DurchblickItemConfig const& cfg) override;
+    void AccountResources(ResourceUsage& usage) override;
 };
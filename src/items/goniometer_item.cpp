@@ -0,0 +1,101 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "goniometer_item.hpp"
+#include <algorithm>
+
+// Correlation below this points to an inverted channel and flashes the cell
+#define CORRELATION_ALARM -0.5f
+#define CORRELATION_WARNING 0.f
+
+#define COLOR_GONIOMETER_POINTS ARGB32(0xff, 0x4c, 0xff, 0x4c)
+#define COLOR_GONIOMETER_GRID ARGB32(0xff, 0x40, 0x40, 0x40)
+
+GoniometerItem::GoniometerItem(Layout* parent, int x, int y, int w, int h)
+    : AudioItem(parent, std::make_unique<Goniometer>(), x, y, w, h)
+    , m_goniometer(static_cast<Goniometer*>(Consumer()))
+{
+}
+
+QWidget* GoniometerItem::GetConfigWidget()
+{
+    auto* w = new GoniometerItemWidget();
+    AddAudioSources(w->m_combo_box);
+    return w;
+}
+
+void GoniometerItem::LoadConfigFromWidget(QWidget* w)
+{
+    auto* custom = dynamic_cast<GoniometerItemWidget*>(w);
+    if (!custom)
+        return;
+    OBSSourceAutoRelease src = obs_get_source_by_name(qt_to_utf8(custom->m_combo_box->currentText()));
+    SetSource(src);
+}
+
+void GoniometerItem::Render(DurchblickItemConfig const& cfg)
+{
+    LayoutItem::Render(cfg);
+
+    const float name_height = m_inner_height * .12f;
+    const float bar_height = std::max(4.f, m_inner_height * .05f);
+    const float top = name_height * 1.25f;
+    const float size = std::min<float>(m_inner_width, m_inner_height - top - bar_height * 3);
+    if (size < 8)
+        return;
+
+    DrawName(0, 0, m_inner_width, name_height);
+
+    // Mid and side axes
+    const float cx = m_inner_width / 2.f, cy = top + size / 2.f, radius = size / 2.f;
+    DrawBox(cx - radius, cy, size, 1, COLOR_GONIOMETER_GRID);
+    DrawBox(cx, top, 1, size, COLOR_GONIOMETER_GRID);
+
+    // The whole figure is one point list and one draw call
+    auto const& points = m_goniometer->Read();
+    vec3* v = m_points.Map(Goniometer::POINTS);
+    if (v) {
+        for (uint32_t i = 0; i < Goniometer::POINTS; i++) {
+            float x = std::clamp(points.x[i], -1.f, 1.f);
+            float y = std::clamp(points.y[i], -1.f, 1.f);
+            vec3_set(&v[i], cx + x * radius, cy - y * radius, 0);
+        }
+        m_points.Draw(GS_POINTS, COLOR_GONIOMETER_POINTS);
+    }
+
+    // Correlation from -1 on the left to +1 on the right
+    const float correlation = m_goniometer->Correlation();
+    const float bar_y = m_inner_height - bar_height * 1.5f;
+    const float bar_left = cx - radius;
+    uint32_t color = COLOR_PREVIEW_INDICATOR;
+    if (correlation < CORRELATION_ALARM)
+        color = COLOR_PROGRAM_INDICATOR;
+    else if (correlation < CORRELATION_WARNING)
+        color = ARGB32(0xff, 0xff, 0xff, 0x4c);
+    DrawBox(bar_left, bar_y, size, bar_height, COLOR_GONIOMETER_GRID);
+    DrawBox(cx, bar_y - 2, 1, bar_height + 4, COLOR_BORDER_GRAY);
+    const float marker = bar_left + (correlation + 1) / 2 * (size - 3);
+    DrawBox(marker, bar_y - 2, 3, bar_height + 4, color);
+}
+
+uint32_t GoniometerItem::GetFillColor()
+{
+    auto fallback = LayoutItem::GetFillColor();
+    if (GetSource() && m_goniometer->Correlation() < CORRELATION_ALARM)
+        return FlashColor(COLOR_ALARM_AUDIO, fallback);
+    return fallback;
+}
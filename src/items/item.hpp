@@ -18,12 +18,14 @@
 
 #pragma once
 #include "../util/callbacks.h"
+#include "../util/resource_usage.hpp"
 #include "../util/util.h"
 #include <QContextMenuEvent>
 #include <QJsonObject>
 #include <QMenu>
 #include <QObject>
 #include <obs-module.h>
+#include <util/platform.h>
 
 class Layout;
 
@@ -84,6 +86,7 @@ public:
         Qt::MouseButtons buttons;
         QEvent::Type type;
         bool double_click {};
+        int wheel_delta {}; // Angle delta of wheel events in eighths of a degree, positive when scrolled away from the user
         MouseData(int _x, int _y, Qt::KeyboardModifiers const& m, Qt::MouseButtons const& mb, QEvent::Type const& t)
             : x(_x)
             , y(_y)
@@ -123,6 +126,9 @@ public:
     /// Determines the border of the cell when it is not hovered
     virtual uint32_t GetFillColor() { return COLOR_BORDER_GRAY; }
 
+    /// UI thread, adds everything the item keeps alive
+    virtual void AccountResources(ResourceUsage& usage) { usage.items++; }
+
     virtual QWidget* GetConfigWidget() { return nullptr; }
     virtual void LoadConfigFromWidget(QWidget*) { }
 
@@ -184,6 +190,12 @@ public:
         m_inner_height = m_height - cfg.border2;
     }
 
+    /// Alternates between color and fallback twice a second, used to draw attention to alarms
+    static uint32_t FlashColor(uint32_t color, uint32_t fallback)
+    {
+        return (os_gettime_ns() / 250000000) & 1 ? fallback : color;
+    }
+
     static void DrawBox(float cx, float cy, uint32_t colorVal)
     {
         assert(cx > 0 && cy > 0);
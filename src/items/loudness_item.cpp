@@ -0,0 +1,166 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "loudness_item.hpp"
+#include "../config.hpp"
+#include "../layout.hpp"
+#include "source_item.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Scale of the bars in LUFS / dBTP
+#define LOUDNESS_MIN -50.f
+#define LOUDNESS_MAX 0.f
+
+// Bars turn yellow and red this many LU above the target
+#define LOUDNESS_WARNING 1.f
+#define LOUDNESS_ERROR 5.f
+#define TRUE_PEAK_WARNING -3.f
+#define TRUE_PEAK_ERROR -1.f
+
+static char const* reading_names[] = { "M", "S", "I", "TP" };
+
+LoudnessItem::LoudnessItem(Layout* parent, int x, int y, int w, int h)
+    : AudioItem(parent, std::make_unique<LoudnessMeter>(), x, y, w, h)
+    , m_meter(static_cast<LoudnessMeter*>(Consumer()))
+{
+    for (int i = 0; i < READINGS; i++)
+        m_value_labels[i] = CreateLabel(reading_names[i], 400, 1);
+
+    m_reset = new QAction(T_LOUDNESS_RESET, this);
+    connect(m_reset, &QAction::triggered, this, [this] { m_meter->ResetIntegrated(); });
+
+    // Text sources rebuild their texture on every change, a few updates per second are plenty to read
+    connect(&m_label_timer, &QTimer::timeout, this, &LoudnessItem::UpdateLabels);
+    m_label_timer.start(250);
+}
+
+void LoudnessItem::UpdateLabels()
+{
+    auto r = m_meter->Read();
+    const float values[READINGS] = { r.momentary, r.short_term, r.integrated, r.true_peak };
+
+    for (int i = 0; i < READINGS; i++) {
+        QString text = QString(" %1 %2 ").arg(reading_names[i]);
+        text = std::isfinite(values[i]) ? text.arg(values[i], 0, 'f', 1) : text.arg("---");
+        if (text == m_value_texts[i])
+            continue;
+        m_value_texts[i] = text;
+        OBSDataAutoRelease settings = obs_source_get_settings(m_value_labels[i]);
+        obs_data_set_string(settings, "text", qt_to_utf8(text));
+        obs_source_update(m_value_labels[i], settings);
+    }
+}
+
+QWidget* LoudnessItem::GetConfigWidget()
+{
+    auto* w = new LoudnessItemWidget();
+    AddAudioSources(w->m_combo_box);
+    w->m_target->setValue(m_target);
+    return w;
+}
+
+void LoudnessItem::LoadConfigFromWidget(QWidget* w)
+{
+    auto* custom = dynamic_cast<LoudnessItemWidget*>(w);
+    if (!custom)
+        return;
+    m_target = custom->m_target->value();
+    OBSSourceAutoRelease src = obs_get_source_by_name(qt_to_utf8(custom->m_combo_box->currentText()));
+    SetSource(src);
+}
+
+void LoudnessItem::DrawBar(float x, float y, float cx, float cy, float value, float warning, float error)
+{
+    // Same colors as the volume meters
+    static const struct {
+        uint32_t background, foreground;
+    } zones[] = {
+        { ARGB32(0xff, 0x26, 0x7f, 0x26), ARGB32(0xff, 0x4c, 0xff, 0x4c) },
+        { ARGB32(0xff, 0x7f, 0x7f, 0x26), ARGB32(0xff, 0xff, 0xff, 0x4c) },
+        { ARGB32(0xff, 0x7f, 0x26, 0x26), ARGB32(0xff, 0xff, 0x4c, 0x4c) },
+    };
+    const float bounds[] = { LOUDNESS_MIN, warning, error, LOUDNESS_MAX };
+    auto pos = [=](float level) {
+        level = std::clamp(level, LOUDNESS_MIN, LOUDNESS_MAX);
+        return y + cy - (level - LOUDNESS_MIN) / (LOUDNESS_MAX - LOUDNESS_MIN) * cy;
+    };
+
+    for (int i = 0; i < 3; i++) {
+        float lo = pos(bounds[i]), hi = pos(bounds[i + 1]);
+        if (lo - hi >= 1)
+            DrawBox(x, hi, cx, lo - hi, zones[i].background);
+        if (value > bounds[i]) {
+            float top = pos(std::min(value, bounds[i + 1]));
+            if (lo - top >= 1)
+                DrawBox(x, top, cx, lo - top, zones[i].foreground);
+        }
+    }
+}
+
+void LoudnessItem::Render(DurchblickItemConfig const& cfg)
+{
+    LayoutItem::Render(cfg);
+
+    auto r = m_meter->Read();
+    const float values[READINGS] = { r.momentary, r.short_term, r.integrated, r.true_peak };
+    const float column = m_inner_width / float(READINGS);
+    const float row = m_inner_height * .12f;
+    const float bar_top = row * 1.25f, bar_height = m_inner_height - row * 2.5f;
+    if (column < 4 || bar_height < 4)
+        return;
+
+    DrawName(0, 0, m_inner_width, row);
+
+    for (int i = 0; i < READINGS; i++) {
+        const float x = column * i, bar_width = column * .4f;
+        const float bar_x = x + (column - bar_width) / 2;
+        if (i < READINGS - 1) {
+            DrawBar(bar_x, bar_top, bar_width, bar_height, values[i], m_target + LOUDNESS_WARNING, m_target + LOUDNESS_ERROR);
+            // Target marker
+            float target = bar_top + bar_height - (m_target - LOUDNESS_MIN) / (LOUDNESS_MAX - LOUDNESS_MIN) * bar_height;
+            DrawBox(x + column * .15f, target - 1, column * .7f, 2, COLOR_BORDER_GRAY);
+        } else {
+            DrawBar(bar_x, bar_top, bar_width, bar_height, values[i], TRUE_PEAK_WARNING, TRUE_PEAK_ERROR);
+        }
+        DrawLabel(m_value_labels[i], x, m_inner_height - row, column, row);
+    }
+}
+
+void LoudnessItem::WriteToJson(QJsonObject& Obj)
+{
+    AudioItem::WriteToJson(Obj);
+    Obj["target"] = m_target;
+}
+
+void LoudnessItem::ReadFromJson(QJsonObject const& Obj)
+{
+    AudioItem::ReadFromJson(Obj);
+    m_target = Obj["target"].toDouble(-23);
+}
+
+void LoudnessItem::ContextMenu(QMenu& m)
+{
+    m.addAction(m_reset);
+}
+
+void LoudnessItem::AccountResources(ResourceUsage& usage)
+{
+    AudioItem::AccountResources(usage);
+    for (auto const& label : m_value_labels)
+        usage.AddLabel(label);
+}
@@ -0,0 +1,83 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+
+#pragma once
+
+#include "../util/loudness_meter.hpp"
+#include "../util/util.h"
+#include "audio_item.hpp"
+#include <QComboBox>
+#include <QDoubleSpinBox>
+#include <QFormLayout>
+#include <QTimer>
+#include <obs.hpp>
+
+class LoudnessItemWidget : public QWidget {
+    Q_OBJECT
+public:
+    QComboBox* m_combo_box;
+    QDoubleSpinBox* m_target;
+    LoudnessItemWidget(QWidget* parent = nullptr)
+        : QWidget(parent)
+    {
+        auto* l = new QFormLayout(this);
+        setLayout(l);
+        l->setContentsMargins(0, 0, 0, 0);
+        m_combo_box = new QComboBox(this);
+        m_combo_box->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
+        m_target = new QDoubleSpinBox(this);
+        m_target->setMinimum(-36);
+        m_target->setMaximum(-5);
+        m_target->setDecimals(0);
+        m_target->setValue(-23);
+        m_target->setSuffix(" LUFS");
+        l->addRow(T_SOURCE_NAME, m_combo_box);
+        l->addRow(T_LOUDNESS_TARGET, m_target);
+        setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    }
+};
+
+// Momentary, short-term and integrated loudness plus true-peak of one audio source
+class LoudnessItem : public AudioItem {
+    Q_OBJECT
+    static constexpr int READINGS = 4;
+
+    LoudnessMeter* m_meter;
+    float m_target { -23 };
+    QAction* m_reset;
+
+    QTimer m_label_timer;
+    OBSSource m_value_labels[READINGS];
+    QString m_value_texts[READINGS];
+
+    void UpdateLabels();
+    void DrawBar(float x, float y, float cx, float cy, float value, float warning, float error);
+
+public:
+    LoudnessItem(Layout* parent, int x, int y, int w = 1, int h = 1);
+
+    QWidget* GetConfigWidget() override;
+    void LoadConfigFromWidget(QWidget*) override;
+    void Render(DurchblickItemConfig const& cfg) override;
+
+    void WriteToJson(QJsonObject& Obj) override;
+    void ReadFromJson(QJsonObject const& Obj) override;
+
+    void ContextMenu(QMenu&) override;
+    void AccountResources(ResourceUsage& usage) override;
+};
@@ -17,12 +17,19 @@
  *************************************************************************/
 
 #include "registry.hpp"
+#include "../util/meter_batch.hpp"
+#include "../util/shm_output.hpp"
 #include "../util/util.h"
 #include "audio_mixer.hpp"
 #include "custom_item.hpp"
+#include "goniometer_item.hpp"
+#include "loudness_item.hpp"
 #include "preview_program_item.hpp"
 #include "scene_item.hpp"
+#include "scope_item.hpp"
 #include "source_item.hpp"
+#include "spectrum_item.hpp"
+#include <util/profiler.hpp>
 
 namespace Registry {
 
@@ -88,6 +95,7 @@ void Free()
 
 void RegisterDefaults()
 {
+    ProfileScope("Registry::RegisterDefaults");
     std::lock_guard<std::mutex> lock(EntryMutex);
     // Keep this one first otherwise it'll mess up the dialog combobox
     Registry::Register<PlaceholderItem>("PlaceholderItem");
@@ -95,10 +103,16 @@ void RegisterDefaults()
     // Last one shows up first in the combobox
     Registry::Register<PreviewProgramItem>(T_WIDGET_PREVIEW_PROGRAM);
     Registry::Register<SourceItem>(T_WIDGET_SOURCE);
+    Registry::Register<ScopeItem>(T_WIDGET_SCOPES);
+    Registry::Register<GoniometerItem>(T_WIDGET_GONIOMETER);
+    Registry::Register<SpectrumItem>(T_WIDGET_SPECTRUM);
+    Registry::Register<LoudnessItem>(T_WIDGET_LOUDNESS);
     Registry::Register<AudioMixerItem>(T_WIDGET_AUDIO_MIXER);
     Registry::Register<SceneItem>(T_WIDGET_SCENE);
 
     Registry::AddCallbacks<SourceItem>();
+    Registry::AddCallbacks<MeterBatch>();
+    Registry::AddCallbacks<ShmOutput>();
 }
 
 LayoutItem* MakeItem(Layout* l, QJsonObject const& obj)
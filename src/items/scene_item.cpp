@@ -108,9 +108,10 @@ void SceneItem::Render(DurchblickItemConfig const& cfg)
 
 uint32_t SceneItem::GetFillColor()
 {
-    if (m_indicator_type == Indicator::BORDER)
-        return GetIndicatorColor();
-    return LayoutItem::GetFillColor();
+    auto color = m_indicator_type == Indicator::BORDER ? GetIndicatorColor() : LayoutItem::GetFillColor();
+    // Problems with the feed are more important than the preview/program indicator
+    auto alarm = AlarmColor(color ? color : COLOR_BORDER_GRAY);
+    return alarm ? alarm : color;
 }
 
 void SceneItem::ReadFromJson(QJsonObject const& Obj)
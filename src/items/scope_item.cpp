@@ -0,0 +1,176 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "scope_item.hpp"
+#include "../util/display_helpers.hpp"
+#include <QStringList>
+#include <algorithm>
+
+#define COLOR_SCOPE_GRID ARGB32(0xff, 0x40, 0x40, 0x40)
+
+// Limited range black and white, anything outside of them is not broadcast safe
+#define LEGAL_BLACK 16
+#define LEGAL_WHITE 235
+
+void ScopeItem::OBSSourceRemoved(void* data, calldata_t*)
+{
+    // Drops the showing reference and falls back to the program output like any other reset
+    reinterpret_cast<ScopeItem*>(data)->SetSource(nullptr);
+}
+
+ScopeItem::ScopeItem(Layout* parent, int x, int y, int w, int h)
+    : LayoutItem(parent, x, y, w, h)
+{
+}
+
+ScopeItem::~ScopeItem()
+{
+    SetSource(nullptr);
+}
+
+void ScopeItem::SetSource(obs_source_t* src)
+{
+    if (m_src) {
+        obs_source_dec_showing(m_src);
+        removedSignal.Disconnect();
+    }
+
+    m_src = src;
+    m_program = !src;
+    if (m_src) {
+        removedSignal.Connect(obs_source_get_signal_handler(m_src), "remove", ScopeItem::OBSSourceRemoved, this);
+        // Hidden sources might not update, the scopes count as a view of them
+        obs_source_inc_showing(m_src);
+    }
+}
+
+QWidget* ScopeItem::GetConfigWidget()
+{
+    auto* w = new ScopeItemWidget();
+    QStringList names;
+
+    obs_enum_scenes([](void* d, obs_source_t* src) -> bool {
+        static_cast<QStringList*>(d)->append(utf8_to_qt(obs_source_get_name(src)));
+        return true;
+    },
+        &names);
+    obs_enum_sources([](void* d, obs_source_t* src) -> bool {
+        if (obs_source_get_output_flags(src) & OBS_SOURCE_VIDEO)
+            static_cast<QStringList*>(d)->append(utf8_to_qt(obs_source_get_name(src)));
+        return true;
+    },
+        &names);
+    names.sort();
+
+    // The program output has no name, it's the empty item data
+    w->m_combo_box->addItem(T_PROGRAM, QString());
+    for (auto const& name : names)
+        w->m_combo_box->addItem(name, name);
+    if (m_src)
+        w->m_combo_box->setCurrentIndex(std::max(0, w->m_combo_box->findData(utf8_to_qt(obs_source_get_name(m_src)))));
+    w->m_interval->setValue(m_scope.Interval());
+    return w;
+}
+
+void ScopeItem::LoadConfigFromWidget(QWidget* w)
+{
+    auto* custom = dynamic_cast<ScopeItemWidget*>(w);
+    if (!custom)
+        return;
+    m_scope.SetInterval(custom->m_interval->value());
+
+    auto name = custom->m_combo_box->currentData().toString();
+    OBSSourceAutoRelease src = name.isEmpty() ? nullptr : obs_get_source_by_name(qt_to_utf8(name));
+    SetSource(src);
+}
+
+void ScopeItem::RenderFeed(DurchblickItemConfig const& cfg)
+{
+    if (m_program) {
+        if (m_scope.BeginCapture(cfg.canvas_width, cfg.canvas_height)) {
+            obs_render_main_texture();
+            m_scope.EndCapture();
+        }
+    } else if (m_src) {
+        if (m_scope.BeginCapture(obs_source_get_width(m_src), obs_source_get_height(m_src))) {
+            obs_source_video_render(m_src);
+            m_scope.EndCapture();
+        }
+    }
+    m_scope.Poll();
+}
+
+void ScopeItem::Render(DurchblickItemConfig const& cfg)
+{
+    LayoutItem::Render(cfg);
+    RenderFeed(cfg);
+
+    // Waveform and vectorscope side by side, each one LEVELS high
+    int x {}, y {};
+    float scale {};
+    GetScaleAndCenterPos(VideoScope::IMAGE_CX, VideoScope::IMAGE_CY, m_inner_width, m_inner_height, x, y, scale);
+    if (scale <= 0)
+        return;
+
+    gs_matrix_push();
+    gs_matrix_translate3f(x, y, 0);
+    gs_matrix_scale3f(scale, scale, 1);
+
+    const float level = 1.f / scale; // One pixel on screen
+    const float waveform = VideoScope::SAMPLE_CX, size = VideoScope::LEVELS;
+    for (int l : { LEGAL_BLACK, LEGAL_WHITE })
+        DrawBox(0, size - 1 - l, waveform, level, COLOR_SCOPE_GRID);
+    DrawBox(waveform, size / 2, size, level, COLOR_SCOPE_GRID);
+    DrawBox(waveform + size / 2, 0, level, size, COLOR_SCOPE_GRID);
+    DrawBox(waveform, 0, level, size, COLOR_SCOPE_GRID);
+
+    if (auto* tex = m_scope.Texture()) {
+        auto* effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+        gs_effect_set_texture(gs_effect_get_param_by_name(effect, "image"), tex);
+        while (gs_effect_loop(effect, "Draw"))
+            gs_draw_sprite(tex, 0, 0, 0);
+    }
+    gs_matrix_pop();
+}
+
+void ScopeItem::WriteToJson(QJsonObject& Obj)
+{
+    LayoutItem::WriteToJson(Obj);
+    if (m_src)
+        Obj["source"] = utf8_to_qt(obs_source_get_name(m_src));
+    Obj["interval"] = m_scope.Interval();
+}
+
+void ScopeItem::ReadFromJson(QJsonObject const& Obj)
+{
+    LayoutItem::ReadFromJson(Obj);
+    m_scope.SetInterval(std::clamp(Obj["interval"].toInt(100), 20, 2000));
+
+    QString source_name = Obj["source"].toString();
+    OBSSourceAutoRelease src = source_name.isEmpty() ? nullptr : obs_get_source_by_name(qt_to_utf8(source_name));
+    if (!source_name.isEmpty() && !src)
+        bwarn("Source '%s' for video scopes not found during load, showing the program output", qt_to_utf8(source_name));
+    SetSource(src);
+}
+
+void ScopeItem::AccountResources(ResourceUsage& usage)
+{
+    LayoutItem::AccountResources(usage);
+    if (m_src)
+        usage.showing_refs++;
+    m_scope.AccountResources(usage);
+}
@@ -0,0 +1,80 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+
+#pragma once
+
+#include "../util/util.h"
+#include "../util/video_scope.hpp"
+#include "item.hpp"
+#include <QComboBox>
+#include <QFormLayout>
+#include <QSpinBox>
+#include <obs.hpp>
+
+class ScopeItemWidget : public QWidget {
+    Q_OBJECT
+public:
+    QComboBox* m_combo_box;
+    QSpinBox* m_interval;
+    ScopeItemWidget(QWidget* parent = nullptr)
+        : QWidget(parent)
+    {
+        auto* l = new QFormLayout(this);
+        setLayout(l);
+        l->setContentsMargins(0, 0, 0, 0);
+        m_combo_box = new QComboBox(this);
+        m_combo_box->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
+        m_interval = new QSpinBox(this);
+        m_interval->setMinimum(20);
+        m_interval->setMaximum(2000);
+        m_interval->setValue(100);
+        m_interval->setSuffix(" ms");
+        l->addRow(T_SOURCE_NAME, m_combo_box);
+        l->addRow(T_SCOPES_INTERVAL, m_interval);
+        setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    }
+};
+
+// Luma waveform and vectorscope of the program output, a scene or a video source
+class ScopeItem : public LayoutItem {
+    Q_OBJECT
+    OBSSource m_src;
+    OBSSignal removedSignal;
+    bool m_program { true };
+    VideoScope m_scope;
+
+    void RenderFeed(DurchblickItemConfig const& cfg);
+
+public:
+    static void OBSSourceRemoved(void* data, calldata_t* params);
+    ScopeItem(Layout* parent, int x, int y, int w = 1, int h = 1);
+    ~ScopeItem();
+
+    /// nullptr switches to the program output
+    void SetSource(obs_source_t* src);
+
+    QWidget* GetConfigWidget() override;
+    void LoadConfigFromWidget(QWidget*) override;
+    void Render(DurchblickItemConfig const& cfg) override;
+
+    void WriteToJson(QJsonObject& Obj) override;
+    void ReadFromJson(QJsonObject const& Obj) override;
+
+    void ContextMenu(QMenu&) override { }
+    void AccountResources(ResourceUsage& usage) override;
+};
@@ -4,6 +4,7 @@
 #include "../util/display_helpers.hpp"
 #include <QApplication>
 #include <QMainWindow>
+#include <cmath>
 #include <obs-frontend-api.h>
 #include <util/util.hpp>
 
@@ -90,6 +91,8 @@ SourceItem::SourceItem(Layout* parent, int x, int y, int w, int h)
     m_toggle_label->setCheckable(true);
     m_toggle_volume = new QAction(T_SOURCE_ITEM_VOLUME, this);
     m_toggle_volume->setCheckable(true);
+    m_toggle_feed_monitor = new QAction(T_SOURCE_ITEM_MONITOR, this);
+    m_toggle_feed_monitor->setCheckable(true);
     SetSource(placeholder_source);
 
     // Set default state before connecting signals to avoid triggering saves during construction
@@ -100,6 +103,10 @@ SourceItem::SourceItem(Layout* parent, int x, int y, int w, int h)
     connect(m_toggle_safe_borders, &QAction::toggled, [] { Config::Save(); });
     connect(m_toggle_label, &QAction::toggled, [] { Config::Save(); });
     connect(m_toggle_volume, &QAction::toggled, [] { Config::Save(); });
+    connect(m_toggle_feed_monitor, &QAction::toggled, this, [this](bool b) {
+        m_feed_monitor.SetEnabled(b);
+        Config::Save();
+    });
 }
 
 SourceItem::~SourceItem()
@@ -164,6 +171,7 @@ void SourceItem::SetSource(obs_source_t* src)
     }
 
     m_src = src;
+    m_feed_monitor.Restart();
     if (m_src) {
         const char* src_name = obs_source_get_name(m_src);
         blog(LOG_INFO, "[Command Center] SetSource called with: %s", src_name);
@@ -192,12 +200,16 @@ void SourceItem::ReadFromJson(QJsonObject const& Obj)
     m_toggle_safe_borders->blockSignals(true);
     m_toggle_label->blockSignals(true);
     m_toggle_volume->blockSignals(true);
+    m_toggle_feed_monitor->blockSignals(true);
     m_toggle_safe_borders->setChecked(Obj["show_safe_borders"].toBool());
     m_toggle_label->setChecked(Obj["show_label"].toBool());
     m_toggle_volume->setChecked(Obj["show_volume"].toBool());
+    m_toggle_feed_monitor->setChecked(Obj["feed_monitor"].toBool());
     m_toggle_safe_borders->blockSignals(false);
     m_toggle_label->blockSignals(false);
     m_toggle_volume->blockSignals(false);
+    m_toggle_feed_monitor->blockSignals(false);
+    m_feed_monitor.SetEnabled(EnableFeedMonitor() && m_toggle_feed_monitor->isChecked());
 
     if (Obj["font_scale"].isDouble())
         m_font_scale = Obj["font_scale"].toDouble(1);
@@ -253,6 +265,7 @@ void SourceItem::WriteToJson(QJsonObject& Obj)
     Obj["show_safe_borders"] = m_toggle_safe_borders->isChecked();
     Obj["show_label"] = m_toggle_label->isChecked();
     Obj["show_volume"] = m_toggle_volume->isChecked();
+    Obj["feed_monitor"] = m_toggle_feed_monitor->isChecked();
     Obj["font_scale"] = m_font_scale;
     Obj["volume_meter_channel_width"] = m_channel_width;
     Obj["volume_meter_height"] = m_volume_meter_height;
@@ -287,16 +300,32 @@ void SourceItem::Render(DurchblickItemConfig const& cfg)
         m_scale.y = m_scale.x;
     }
 
+    // While monitoring the source is drawn into a texture at the size it has in the cell on
+    // every frame, the cell always shows that and the feed monitor samples it every few frames
+    gs_texture_t* cell = nullptr;
+    uint32_t cell_cx = uint32_t(ceilf(qMin(w * m_scale.x * cfg.scale, float(w))));
+    uint32_t cell_cy = uint32_t(ceilf(qMin(h * m_scale.y * cfg.scale, float(h))));
+    if (m_src != placeholder_source && m_feed_monitor.BeginCell(w, h, cell_cx, cell_cy)) {
+        obs_source_video_render(m_src);
+        cell = m_feed_monitor.EndCell();
+    }
+    m_feed_monitor.Poll();
+
     gs_matrix_push();
     gs_matrix_translate3f(offset_x, offset_y, 0);
     gs_matrix_scale3f(m_scale.x, m_scale.y, 1);
-    obs_source_video_render(m_src);
+    if (cell)
+        FeedMonitor::DrawCell(cell, w, h);
+    else
+        obs_source_video_render(m_src);
     if (m_toggle_safe_borders->isChecked())
         RenderSafeMargins(w, h);
     gs_matrix_pop();
 
-    if (m_vol_meter && obs_source_active(m_src))
-        m_vol_meter->Render(cfg.scale, m_scale.x, m_scale.y);
+    if (m_vol_meter && obs_source_active(m_src)) {
+        m_vol_meter->Render(m_layout->Meters(), cfg.scale, m_scale.x, m_scale.y);
+        m_layout->Meters().Flush(); // Below the label
+    }
 
     // Label has to be scaled and translated regardless of
     // source/scene size because sources can have sizes different than the base canvas
@@ -332,6 +361,35 @@ void SourceItem::ContextMenu(QMenu& m)
     m.addAction(m_toggle_label);
     if (EnableVolumeMeter())
         m.addAction(m_toggle_volume);
+    if (EnableFeedMonitor())
+        m.addAction(m_toggle_feed_monitor);
+}
+
+uint32_t SourceItem::AlarmColor(uint32_t fallback)
+{
+    if (m_feed_monitor.GetAlarm() != FeedMonitor::Alarm::None)
+        return FlashColor(COLOR_ALARM_VIDEO, fallback);
+    if (m_vol_meter && m_vol_meter->GetAlarm() != VolmeterHub::AudioAlarm::None)
+        return FlashColor(COLOR_ALARM_AUDIO, fallback);
+    return 0;
+}
+
+uint32_t SourceItem::GetFillColor()
+{
+    auto fallback = LayoutItem::GetFillColor();
+    auto alarm = AlarmColor(fallback);
+    return alarm ? alarm : fallback;
+}
+
+void SourceItem::AccountResources(ResourceUsage& usage)
+{
+    LayoutItem::AccountResources(usage);
+    if (m_src)
+        usage.showing_refs++;
+    usage.AddLabel(m_label);
+    if (m_vol_meter)
+        m_vol_meter->AccountResources(usage);
+    m_feed_monitor.AccountResources(usage);
 }
 
 void SourceItem::MouseEvent(MouseData const& e, DurchblickItemConfig const& cfg)
@@ -17,6 +17,7 @@
  *************************************************************************/
 
 #pragma once
+#include "../util/feed_monitor.hpp"
 #include "../util/util.h"
 #include "../util/volume_meter.hpp"
 #include "item.hpp"
@@ -116,13 +117,18 @@ protected:
     QAction* m_toggle_safe_borders;
     QAction* m_toggle_label;
     QAction* m_toggle_volume;
+    QAction* m_toggle_feed_monitor;
     std::unique_ptr<MixerMeter> m_vol_meter {};
+    FeedMonitor m_feed_monitor;
     float m_font_scale { 1 };
     float m_volume_meter_height { .5 };
     int m_volume_meter_x { 10 }, m_volume_meter_y { 10 };
     int m_channel_width { 2 };
     void RenderSafeMargins(int w, int h);
     vec2 m_scale {};
+
+    /// Flashing border color while the video or, if the meter is shown, the audio of the feed has a problem, 0 otherwise
+    uint32_t AlarmColor(uint32_t fallback);
 public slots:
 
     void VolumeToggled(bool);
@@ -161,6 +167,9 @@ public:
     virtual void Render(DurchblickItemConfig const& cfg) override;
     virtual void ContextMenu(QMenu&) override;
     virtual void MouseEvent(MouseData const& e, DurchblickItemConfig const& cfg) override;
+    virtual uint32_t GetFillColor() override;
+    virtual void AccountResources(ResourceUsage& usage) override;
 
     virtual bool EnableVolumeMeter() const { return true; }
+    virtual bool EnableFeedMonitor() const { return true; }
 };
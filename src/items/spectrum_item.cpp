@@ -0,0 +1,106 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "spectrum_item.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Level range of the bars in dBFS
+#define SPECTRUM_MIN -80.f
+#define SPECTRUM_MAX 0.f
+
+#define COLOR_SPECTRUM_BAR ARGB32(0xff, 0x4c, 0xff, 0x4c)
+#define COLOR_SPECTRUM_GRID ARGB32(0xff, 0x40, 0x40, 0x40)
+
+SpectrumItem::SpectrumItem(Layout* parent, int x, int y, int w, int h)
+    : AudioItem(parent, std::make_unique<SpectrumAnalyzer>(), x, y, w, h)
+    , m_analyzer(static_cast<SpectrumAnalyzer*>(Consumer()))
+{
+}
+
+QWidget* SpectrumItem::GetConfigWidget()
+{
+    auto* w = new SpectrumItemWidget();
+    AddAudioSources(w->m_combo_box);
+    w->m_hop->setValue(m_analyzer->Hop());
+    return w;
+}
+
+void SpectrumItem::LoadConfigFromWidget(QWidget* w)
+{
+    auto* custom = dynamic_cast<SpectrumItemWidget*>(w);
+    if (!custom)
+        return;
+    m_analyzer->SetHop(custom->m_hop->value());
+    OBSSourceAutoRelease src = obs_get_source_by_name(qt_to_utf8(custom->m_combo_box->currentText()));
+    SetSource(src);
+}
+
+void SpectrumItem::Render(DurchblickItemConfig const& cfg)
+{
+    LayoutItem::Render(cfg);
+
+    const float name_height = m_inner_height * .12f;
+    const float top = name_height * 1.25f;
+    const float height = m_inner_height - top;
+    const float width = m_inner_width;
+    if (width < SpectrumAnalyzer::BANDS || height < 4)
+        return;
+
+    DrawName(0, 0, m_inner_width, name_height);
+
+    // Decades, so the bars can be told apart
+    const float low = SpectrumAnalyzer::LOW_FREQUENCY, high = m_analyzer->HighFrequency();
+    for (float f : { 100.f, 1000.f, 10000.f }) {
+        if (f < high)
+            DrawBox(width * logf(f / low) / logf(high / low), top, 1, height, COLOR_SPECTRUM_GRID);
+    }
+
+    // All bars go into one buffer and one draw call
+    auto const& bands = m_analyzer->Read();
+    vec3* v = m_bars.Map(SpectrumAnalyzer::BANDS * 6);
+    if (!v)
+        return;
+
+    const float bar_width = width / SpectrumAnalyzer::BANDS;
+    const float gap = bar_width > 4 ? 1.f : 0.f;
+    const float bottom = top + height;
+    for (int b = 0; b < SpectrumAnalyzer::BANDS; b++, v += 6) {
+        float level = std::clamp(bands[b], SPECTRUM_MIN, SPECTRUM_MAX);
+        float y = bottom - (level - SPECTRUM_MIN) / (SPECTRUM_MAX - SPECTRUM_MIN) * height;
+        float left = b * bar_width, right = left + bar_width - gap;
+        vec3_set(&v[0], left, y, 0);
+        vec3_set(&v[1], right, y, 0);
+        vec3_set(&v[2], left, bottom, 0);
+        vec3_set(&v[3], left, bottom, 0);
+        vec3_set(&v[4], right, y, 0);
+        vec3_set(&v[5], right, bottom, 0);
+    }
+    m_bars.Draw(GS_TRIS, COLOR_SPECTRUM_BAR);
+}
+
+void SpectrumItem::WriteToJson(QJsonObject& Obj)
+{
+    AudioItem::WriteToJson(Obj);
+    Obj["hop"] = m_analyzer->Hop();
+}
+
+void SpectrumItem::ReadFromJson(QJsonObject const& Obj)
+{
+    AudioItem::ReadFromJson(Obj);
+    m_analyzer->SetHop(std::clamp(Obj["hop"].toInt(20), 5, 200));
+}
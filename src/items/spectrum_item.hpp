@@ -0,0 +1,70 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+
+#pragma once
+
+#include "../util/spectrum_analyzer.hpp"
+#include "../util/util.h"
+#include "../util/vertex_stream.hpp"
+#include "audio_item.hpp"
+#include <QComboBox>
+#include <QFormLayout>
+#include <QSpinBox>
+
+class SpectrumItemWidget : public QWidget {
+    Q_OBJECT
+public:
+    QComboBox* m_combo_box;
+    QSpinBox* m_hop;
+    SpectrumItemWidget(QWidget* parent = nullptr)
+        : QWidget(parent)
+    {
+        auto* l = new QFormLayout(this);
+        setLayout(l);
+        l->setContentsMargins(0, 0, 0, 0);
+        m_combo_box = new QComboBox(this);
+        m_combo_box->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
+        m_hop = new QSpinBox(this);
+        m_hop->setMinimum(5);
+        m_hop->setMaximum(200);
+        m_hop->setValue(20);
+        m_hop->setSuffix(" ms");
+        l->addRow(T_SOURCE_NAME, m_combo_box);
+        l->addRow(T_SPECTRUM_HOP, m_hop);
+        setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    }
+};
+
+// Spectrum of one audio source as logarithmically spaced bars
+class SpectrumItem : public AudioItem {
+    Q_OBJECT
+    SpectrumAnalyzer* m_analyzer;
+    VertexStream m_bars;
+
+public:
+    SpectrumItem(Layout* parent, int x, int y, int w = 1, int h = 1);
+
+    QWidget* GetConfigWidget() override;
+    void LoadConfigFromWidget(QWidget*) override;
+    void Render(DurchblickItemConfig const& cfg) override;
+
+    void WriteToJson(QJsonObject& Obj) override;
+    void ReadFromJson(QJsonObject const& Obj) override;
+
+    void ContextMenu(QMenu&) override { }
+};
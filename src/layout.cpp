@@ -27,6 +27,7 @@
 #include <QJsonObject>
 #include <obs-frontend-api.h>
 #include <util/config-file.h>
+#include <util/profiler.hpp>
 
 void Layout::FillEmptyCells()
 {
@@ -166,7 +167,7 @@ void Layout::MouseMoved(QMouseEvent* e)
         e->buttons(),
         e->type());
 
-    auto* screen = m_durchblick->windowHandle()->screen();
+    auto* screen = m_durchblick ? m_durchblick->windowHandle()->screen() : nullptr;
     if (screen) {
         d.x *= screen->devicePixelRatio();
         d.y *= screen->devicePixelRatio();
@@ -241,6 +242,21 @@ void Layout::MouseDoubleClicked(QMouseEvent* e)
         Item->MouseEvent(d, m_cfg);
 }
 
+void Layout::MouseWheel(QWheelEvent* e)
+{
+    LayoutItem::MouseData d(
+        int((e->position().x() - m_cfg.x) / m_cfg.scale),
+        int((e->position().y() - m_cfg.y) / m_cfg.scale),
+        e->modifiers(),
+        e->buttons(),
+        e->type());
+    // Treat horizontal scrolling (e.g. shift + wheel or a touchpad) the same as vertical
+    auto delta = e->angleDelta();
+    d.wheel_delta = delta.y() != 0 ? delta.y() : delta.x();
+    for (auto& Item : m_layout_items)
+        Item->MouseEvent(d, m_cfg);
+}
+
 void Layout::HandleContextMenu(QMouseEvent*, QMenu& m)
 {
     if (m_locked) {
@@ -253,6 +269,10 @@ void Layout::HandleContextMenu(QMouseEvent*, QMenu& m)
 
         m.addAction(T_MENU_CONFIGURATION, this, SLOT(ShowLayoutConfigDialog()));
         m.addAction(T_MENU_LOCK, this, SLOT(Lock()));
+        auto* render_cost = m.addAction(T_MENU_RENDER_COST);
+        render_cost->setCheckable(true);
+        render_cost->setChecked(m_profiler != nullptr);
+        connect(render_cost, &QAction::toggled, this, &Layout::SetProfiling);
         std::lock_guard<std::mutex> lock(m_layout_mutex);
 
         for (auto& Item : m_layout_items) {
@@ -269,6 +289,31 @@ void Layout::HandleContextMenu(QMouseEvent*, QMenu& m)
     }
 }
 
+void Layout::SetProfiling(bool enabled)
+{
+    std::unique_ptr<RenderProfiler> old;
+    {
+        std::lock_guard<std::mutex> lock(m_layout_mutex);
+        if (enabled == (m_profiler != nullptr))
+            return;
+        if (enabled)
+            m_profiler = std::make_unique<RenderProfiler>();
+        else
+            old = std::move(m_profiler);
+    }
+    // Destroyed outside of the lock, it enters the graphics context which the render thread holds while waiting for the lock
+}
+
+void Layout::AccountResources(ResourceUsage& usage)
+{
+    std::lock_guard<std::mutex> lock(m_layout_mutex);
+    for (auto const& Item : m_layout_items) {
+        if (Item)
+            Item->AccountResources(usage);
+    }
+    m_meters.AccountResources(usage);
+}
+
 void Layout::FreeSpace(LayoutItem::Cell const& c)
 {
     auto it = std::remove_if(m_layout_items.begin(), m_layout_items.end(), [c](std::unique_ptr<LayoutItem> const& item) {
@@ -314,14 +359,20 @@ void Layout::SetRegion(float bx, float by, float cx, float cy)
 
 void Layout::Render(int, int, uint32_t, uint32_t)
 {
-    if (!m_durchblick->HasSize()) // We need at least one refresh/resize to be sure that we have all necessary data for rendering
+    ProfileScope("Layout::Render");
+    m_rendered_items = 0;
+    if (m_durchblick && !m_durchblick->HasSize()) // We need at least one refresh/resize to be sure that we have all necessary data for rendering
         return;
     // Define the whole usable region for the multiview
     StartRegion(m_cfg.x, m_cfg.y, m_cfg.cx * m_cfg.scale, m_cfg.cy * m_cfg.scale, 0.0f, m_cfg.cx,
         0.0f, m_cfg.cy);
     LayoutItem::DrawBox(m_cfg.cx, m_cfg.cy, COLOR_BORDER_GRAY);
 
+    m_meters.Begin();
     m_layout_mutex.lock();
+    if (m_profiler)
+        m_profiler->BeginFrame(m_cfg.cell_height);
+    m_rendered_items = uint32_t(m_layout_items.size());
     for (auto& Item : m_layout_items) {
         // Change region to item dimensions
         gs_matrix_push();
@@ -337,10 +388,29 @@ void Layout::Render(int, int, uint32_t, uint32_t)
         gs_matrix_push();
         gs_matrix_translate3f(Item->m_rel_left + m_cfg.border, Item->m_rel_top + m_cfg.border, 0);
         SetRegion(Item->m_rel_left + m_cfg.border, Item->m_rel_top + m_cfg.border, Item->m_inner_width, Item->m_inner_height);
-        Item->Render(m_cfg);
+        m_meters.SetClip(0, 0, Item->m_inner_width, Item->m_inner_height);
+        // The class name is static moc data, so all items of a type share one profiler entry
+        auto const* profile_name = Item->metaObject()->className();
+        profile_start(profile_name);
+        if (m_profiler) {
+            m_profiler->BeginItem();
+            Item->Render(m_cfg);
+            m_meters.Flush();
+            m_profiler->EndItem(Item.get());
+            m_profiler->DrawItem(Item.get(), Item->m_inner_width);
+        } else {
+            Item->Render(m_cfg);
+            m_meters.Flush();
+        }
+        profile_end(profile_name);
         EndRegion();
         gs_matrix_pop();
     }
+
+    if (m_profiler) {
+        m_profiler->EndFrame();
+        m_profiler->DrawTotal(m_cfg.cx);
+    }
     m_layout_mutex.unlock();
 
     if (m_dragging) {
@@ -368,6 +438,9 @@ void Layout::Resize(int target_cx, int target_cy, int cx, int cy)
     // We calculate most layout values only on resize here
     m_cfg.canvas_width = target_cx;
     m_cfg.canvas_height = target_cy;
+    m_output_cx = cx;
+    m_output_cy = cy;
+    m_fill_output = false;
 
     float ar = float(target_cx) / float(target_cy);
 
@@ -388,23 +461,47 @@ void Layout::Resize(int target_cx, int target_cy, int cx, int cy)
     m_layout_mutex.unlock();
 }
 
+void Layout::ResizeToFill(int target_cx, int target_cy, int cx, int cy)
+{
+    m_cfg.canvas_width = target_cx;
+    m_cfg.canvas_height = target_cy;
+    m_output_cx = cx;
+    m_output_cy = cy;
+    m_fill_output = true;
+    RefreshGrid();
+}
+
 void Layout::RefreshGrid()
 {
     auto target_cx = m_cfg.canvas_width;
     auto target_cy = m_cfg.canvas_height;
 
-    float ar = float(target_cx) / float(target_cy);
-    m_cfg.cell_width = float(m_cfg.canvas_width) / m_cols;
-    m_cfg.cell_height = m_cfg.cell_width / ar;
+    if (m_fill_output) {
+        // Stays as wide as the canvas, so borders and labels keep their size relative to it
+        m_cfg.cx = target_cx;
+        m_cfg.cy = qMax(int(float(target_cx) * m_output_cy / m_output_cx), 1);
+        m_cfg.cell_width = float(m_cfg.cx) / m_cols;
+        m_cfg.cell_height = float(m_cfg.cy) / m_rows;
+        m_cfg.x = 0;
+        m_cfg.y = 0;
+        m_cfg.scale = float(m_output_cx) / float(target_cx);
+    } else {
+        float ar = float(target_cx) / float(target_cy);
+        m_cfg.cell_width = float(m_cfg.canvas_width) / m_cols;
+        m_cfg.cell_height = m_cfg.cell_width / ar;
 
-    target_cy = m_cfg.cell_height * m_rows;
+        target_cy = m_cfg.cell_height * m_rows;
 
-    m_cfg.cx = target_cx;
-    m_cfg.cy = target_cy;
+        m_cfg.cx = target_cx;
+        m_cfg.cy = target_cy;
 
-    auto* db = static_cast<Durchblick*>(parent());
-    auto s = db->size() * db->devicePixelRatioF();
-    GetScaleAndCenterPos(target_cx, target_cy, s.width(), s.height(), m_cfg.x, m_cfg.y, m_cfg.scale);
+        if (m_durchblick) {
+            auto s = m_durchblick->size() * m_durchblick->devicePixelRatioF();
+            m_output_cx = s.width();
+            m_output_cy = s.height();
+        }
+        GetScaleAndCenterPos(target_cx, target_cy, m_output_cx, m_output_cy, m_cfg.x, m_cfg.y, m_cfg.scale);
+    }
 
     // Delete any cells that don't fit on the screen anymore
     m_layout_mutex.lock();
@@ -456,6 +553,9 @@ void Layout::CreateDefaultLayout()
     m_layout_mutex.unlock();
     obs_frontend_source_list_free(&scenes);
 
+    if (!m_durchblick)
+        return;
+
     auto cfg = obs_frontend_get_app_config();
 
     // Automatically set settings to user default
@@ -467,6 +567,7 @@ void Layout::CreateDefaultLayout()
 
 void Layout::Load(QJsonObject const& obj)
 {
+    ProfileScope("Layout::Load");
     Clear();
 
     m_layout_mutex.lock();
@@ -518,7 +619,7 @@ void Layout::DeleteLayout()
 
 void Layout::ResetHover()
 {
-    if (m_hovered_cell.col > -1) {
+    if (m_hovered_cell.col > -1 && m_durchblick) {
         m_hovered_cell.col = -1;
         m_hovered_cell.row = -1;
         auto pos = m_durchblick->mapFromGlobal(QCursor::pos());
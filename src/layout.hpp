@@ -22,7 +22,10 @@
 #include "items/registry.hpp"
 #include "ui/layout_config_dialog.hpp"
 #include "ui/new_item_dialog.hpp"
+#include "util/meter_batch.hpp"
+#include "util/render_profiler.hpp"
 #include <QMouseEvent>
+#include <QWheelEvent>
 #include <algorithm>
 #include <memory>
 #include <mutex>
@@ -71,9 +74,14 @@ inline void GetScaleAndCenterPos(int baseCX, int baseCY, int windowCX,
 class Layout : public QObject {
     friend class LayoutConfigDialog;
     int m_cols { 4 }, m_rows { 4 };
+    MeterBatch m_meters; // Has to outlive the items, meters keep lanes in its bank
     std::vector<std::unique_ptr<LayoutItem>> m_layout_items;
+    std::unique_ptr<RenderProfiler> m_profiler; // Only exists while the render cost overlay is shown
     DurchblickItemConfig m_cfg;
-    Durchblick* m_durchblick {};
+    Durchblick* m_durchblick {}; // nullptr for layouts that are rendered headless into a texture
+    int m_output_cx {}, m_output_cy {};
+    bool m_fill_output {}; // Cells take the output's aspect ratio instead of the canvas'
+    uint32_t m_rendered_items {}; // Graphics thread only
     LayoutItem::Cell m_hovered_cell {}, m_selection_start {}, m_selection_end {};
     bool m_dragging {}, m_locked {};
     std::mutex m_layout_mutex;
@@ -107,6 +115,7 @@ private slots:
 
     void Lock() { m_locked = true; }
     void Unlock() { m_locked = false; }
+    void SetProfiling(bool enabled);
 
     void FillSelectionWithScenes();
 
@@ -118,6 +127,7 @@ public:
     void MousePressed(QMouseEvent* e);
     void MouseReleased(QMouseEvent* e);
     void MouseDoubleClicked(QMouseEvent* e);
+    void MouseWheel(QWheelEvent* e);
     void HandleContextMenu(QMouseEvent* e, QMenu& m);
     void FreeSpace(LayoutItem::Cell const& c);
     void AddWidget(Registry::ItemRegistry::Entry const& entry, LayoutItem::Cell const& c, QWidget* custom_widget);
@@ -125,6 +135,8 @@ public:
     void SetRegion(float bx, float by, float cx, float cy);
     void Render(int target_cx, int target_cy, uint32_t cx, uint32_t cy);
     void Resize(int target_cx, int target_cy, int cx, int cy);
+    /// Spreads the grid over the whole output instead of fitting canvas shaped cells into it
+    void ResizeToFill(int target_cx, int target_cy, int cx, int cy);
     void RefreshGrid();
 
     void CreateDefaultLayout();
@@ -132,6 +144,7 @@ public:
     void Save(QJsonObject& obj);
     bool IsEmpty() const { return m_layout_items.empty() || m_cols <= 0 || m_rows <= 0; }
     bool IsLocked() const { return m_locked; }
+    bool IsHeadless() const { return !m_durchblick; }
     void DeleteLayout();
     void ResetHover();
     void Clear()
@@ -143,4 +156,11 @@ public:
     int Columns() const { return m_cols; }
     int Rows() const { return m_rows; }
     DurchblickItemConfig const& Config() const { return m_cfg; }
+    MeterBatch& Meters() { return m_meters; }
+
+    /// Graphics thread, number of items drawn by the last Render()
+    uint32_t RenderedItems() const { return m_rendered_items; }
+
+    /// UI thread
+    void AccountResources(ResourceUsage& usage);
 };
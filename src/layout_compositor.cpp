@@ -0,0 +1,363 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "layout_compositor.hpp"
+#include "config.hpp"
+#include "layout.hpp"
+#include "util/util.h"
+#include <QApplication>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#define MULTIVIEW_SOURCE_ID "durchblick_multiview"
+
+// A wall is rendered into one texture every frame. Its sides can't exceed what GPUs
+// create, and the pixel count stays at 8K UHD, beyond that tiles are upscaled
+#define MAX_TEXTURE_SIZE 16384
+#define MAX_PIXELS (7680 * 4320)
+
+// Sources can create compositors on any thread, but they're only deleted on the UI thread.
+// Maps each live compositor to a serial, so a queued update can tell whether the compositor
+// it was meant for still exists, even if a new one got the same address
+static std::mutex compositors_mutex;
+static std::map<LayoutCompositor*, uint64_t> compositors;
+static uint64_t compositor_serial {};
+// UI thread only
+static std::map<std::tuple<QString, uint32_t, uint32_t>, std::weak_ptr<LayoutCompositor>> shared_compositors;
+
+static void DeleteOnUiThread(LayoutCompositor* c)
+{
+    // Layout items are Qt objects. On the UI thread the compositor is deleted right away,
+    // a queued delete would never run once the event loop stopped at unload
+    if (!qApp || QThread::currentThread() == qApp->thread())
+        delete c;
+    else
+        QMetaObject::invokeMethod(qApp, [c]() { delete c; }, Qt::QueuedConnection);
+}
+
+static bool Alive(LayoutCompositor* c, uint64_t serial)
+{
+    std::lock_guard<std::mutex> lock(compositors_mutex);
+    auto it = compositors.find(c);
+    return it != compositors.end() && it->second == serial;
+}
+
+LayoutCompositor::LayoutCompositor()
+{
+    std::lock_guard<std::mutex> lock(compositors_mutex);
+    m_serial = ++compositor_serial;
+    compositors.emplace(this, m_serial);
+}
+
+LayoutCompositor::~LayoutCompositor()
+{
+    {
+        std::lock_guard<std::mutex> lock(compositors_mutex);
+        compositors.erase(this);
+    }
+    delete m_layout.load();
+    if (m_texrender) {
+        obs_enter_graphics();
+        gs_texrender_destroy(m_texrender);
+        obs_leave_graphics();
+    }
+}
+
+void LayoutCompositor::SetMultiview(QString const& id)
+{
+    m_multiview_id = id;
+    Reload(true);
+}
+
+void LayoutCompositor::ApplySize(uint32_t cx, uint32_t cy)
+{
+    cx = qMax(cx, 1u);
+    cy = qMax(cy, 1u);
+    double scale = std::min({ 1.0, double(MAX_TEXTURE_SIZE) / cx, double(MAX_TEXTURE_SIZE) / cy,
+        std::sqrt(double(MAX_PIXELS) / (double(cx) * double(cy))) });
+    m_cx = qMax(uint32_t(cx * scale), 1u);
+    m_cy = qMax(uint32_t(cy * scale), 1u);
+}
+
+void LayoutCompositor::SetSize(uint32_t cx, uint32_t cy)
+{
+    m_tiles_x = m_tiles_y = 0;
+    ApplySize(cx, cy);
+    Reload(true);
+}
+
+void LayoutCompositor::SetTiles(uint32_t cols, uint32_t rows)
+{
+    m_tiles_x = qMax(cols, 1u);
+    m_tiles_y = qMax(rows, 1u);
+    m_base_cx = m_base_cy = 0; // Reload() picks the size
+    Reload(true);
+}
+
+void LayoutCompositor::Reload(bool force)
+{
+    struct obs_video_info ovi;
+    if (!obs_get_video_info(&ovi))
+        return;
+
+    // Items are placed relative to the base canvas, the layout is rebuilt when it changes
+    if (ovi.base_width != m_base_cx || ovi.base_height != m_base_cy) {
+        m_base_cx = ovi.base_width;
+        m_base_cy = ovi.base_height;
+        if (m_tiles_x > 0)
+            ApplySize(m_tiles_x * ovi.base_width, m_tiles_y * ovi.base_height);
+        force = true;
+    }
+
+    // Only the grid and its items matter, window geometry and the like change far more often
+    QJsonObject data;
+    if (!m_multiview_id.isEmpty()) {
+        auto saved = Config::GetLayoutData(m_multiview_id);
+        for (auto const* key : { "cols", "rows", "items" }) {
+            if (saved.contains(key))
+                data[key] = saved[key];
+        }
+    }
+    if (!force && data == m_loaded)
+        return;
+    m_loaded = data;
+
+    auto* layout = m_layout.load();
+    if (!layout) {
+        layout = new Layout(nullptr);
+        m_layout = layout;
+    }
+
+    // The grid covers the whole texture, whatever its aspect ratio
+    layout->ResizeToFill(ovi.base_width, ovi.base_height, m_cx, m_cy);
+    // Multiviews only exist once the frontend finished loading, RefreshAll() catches up then
+    if (data.isEmpty())
+        layout->Clear();
+    else
+        layout->Load(data);
+}
+
+gs_texture_t* LayoutCompositor::Texture()
+{
+    auto* layout = m_layout.load();
+    // The layout can contain a scene that shows this compositor
+    if (!layout || m_rendering)
+        return nullptr;
+
+    // Nothing tells sources that the base canvas changed, so compare once per render
+    struct obs_video_info ovi;
+    if (obs_get_video_info(&ovi) && (ovi.base_width != m_base_cx || ovi.base_height != m_base_cy)
+        && !m_reload_queued.exchange(true)) {
+        QMetaObject::invokeMethod(
+            qApp, [this, serial = m_serial]() {
+                if (!Alive(this, serial))
+                    return;
+                m_reload_queued = false;
+                Reload(false);
+            },
+            Qt::QueuedConnection);
+    }
+
+    uint32_t cx = m_cx, cy = m_cy;
+    if (!m_texrender)
+        m_texrender = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+
+    // The first caller of a frame draws the layout, every other one samples the result
+    uint64_t frame = obs_get_video_frame_time();
+    if (frame != m_rendered_frame) {
+        m_rendered_frame = frame;
+        gs_texrender_reset(m_texrender);
+    }
+
+    if (gs_texrender_begin(m_texrender, cx, cy)) {
+        m_textures.Resize(m_texture_cx, m_texture_cy, cx, cy, 4);
+        m_rendering = true;
+        vec4 clear_color;
+        vec4_zero(&clear_color);
+        gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
+        gs_ortho(0.0f, float(cx), 0.0f, float(cy), -100.0f, 100.0f);
+
+        gs_blend_state_push();
+        gs_reset_blend_state();
+        layout->Render(0, 0, cx, cy);
+        gs_blend_state_pop();
+
+        gs_texrender_end(m_texrender);
+        m_rendering = false;
+    }
+
+    return gs_texrender_get_texture(m_texrender);
+}
+
+void LayoutCompositor::AccountResources(ResourceUsage& usage)
+{
+    m_textures.Account(usage);
+    if (auto* layout = m_layout.load())
+        layout->AccountResources(usage);
+}
+
+std::shared_ptr<LayoutCompositor> LayoutCompositor::SharedWall(QString const& id, uint32_t cols, uint32_t rows)
+{
+    auto& weak = shared_compositors[{ id, cols, rows }];
+    auto c = weak.lock();
+    if (!c) {
+        c = std::shared_ptr<LayoutCompositor>(new LayoutCompositor(), DeleteOnUiThread);
+        c->SetTiles(cols, rows);
+        c->SetMultiview(id);
+        weak = c;
+    }
+
+    for (auto it = shared_compositors.begin(); it != shared_compositors.end();) {
+        if (it->second.expired())
+            it = shared_compositors.erase(it);
+        else
+            ++it;
+    }
+    return c;
+}
+
+static std::vector<LayoutCompositor*> AllCompositors()
+{
+    // Nothing in the copy can be deleted while the UI thread is busy with it
+    std::lock_guard<std::mutex> lock(compositors_mutex);
+    std::vector<LayoutCompositor*> all;
+    for (auto const& c : compositors)
+        all.emplace_back(c.first);
+    return all;
+}
+
+void LayoutCompositor::RefreshAll()
+{
+    for (auto* c : AllCompositors())
+        c->Reload(false);
+}
+
+void LayoutCompositor::ClearAll()
+{
+    for (auto* c : AllCompositors()) {
+        if (auto* layout = c->m_layout.load())
+            layout->Clear();
+        c->m_loaded = {};
+    }
+}
+
+void LayoutCompositor::Shutdown()
+{
+    // Walls are part of the resources of their tile windows
+    for (auto* c : AllCompositors()) {
+        if (c->m_tiles_x == 0) {
+            ResourceUsage usage;
+            c->AccountResources(usage);
+            binfo("Resources of multiview source for '%s': %s", qt_to_utf8(c->m_multiview_id), qt_to_utf8(usage.Summary()));
+        }
+    }
+    ClearAll();
+    shared_compositors.clear();
+}
+
+static void UpdateSource(LayoutCompositor* c, obs_data_t* settings)
+{
+    auto id = utf8_to_qt(obs_data_get_string(settings, "multiview"));
+    uint32_t cx = uint32_t(obs_data_get_int(settings, "width"));
+    uint32_t cy = uint32_t(obs_data_get_int(settings, "height"));
+
+    // The source can be destroyed before this runs
+    QMetaObject::invokeMethod(
+        qApp, [c, serial = c->Serial(), id, cx, cy]() {
+            if (!Alive(c, serial))
+                return;
+            c->SetSize(cx, cy);
+            c->SetMultiview(id);
+        },
+        Qt::QueuedConnection);
+}
+
+void LayoutCompositor::Register()
+{
+    struct obs_source_info info = {};
+    info.id = MULTIVIEW_SOURCE_ID;
+    info.type = OBS_SOURCE_TYPE_INPUT;
+    info.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_CUSTOM_DRAW;
+    info.get_name = [](void*) { return T_MULTIVIEW_SOURCE; };
+
+    info.create = [](obs_data_t* settings, obs_source_t*) -> void* {
+        // Sources can be created on any thread, the compositor itself is only touched on the UI thread
+        auto* c = new LayoutCompositor();
+        UpdateSource(c, settings);
+        return c;
+    };
+
+    info.destroy = [](void* data) {
+        DeleteOnUiThread(static_cast<LayoutCompositor*>(data));
+    };
+
+    info.update = [](void* data, obs_data_t* settings) {
+        UpdateSource(static_cast<LayoutCompositor*>(data), settings);
+    };
+
+    info.get_defaults = [](obs_data_t* settings) {
+        struct obs_video_info ovi;
+        if (obs_get_video_info(&ovi)) {
+            obs_data_set_default_int(settings, "width", ovi.base_width);
+            obs_data_set_default_int(settings, "height", ovi.base_height);
+        } else {
+            obs_data_set_default_int(settings, "width", 1920);
+            obs_data_set_default_int(settings, "height", 1080);
+        }
+        obs_data_set_default_string(settings, "multiview", "default");
+    };
+
+    info.get_properties = [](void*) {
+        auto* props = obs_properties_create();
+        auto* list = obs_properties_add_list(props, "multiview", T_MULTIVIEW_SOURCE_LAYOUT, OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+        for (auto const& id : Config::GetMultiviewIds()) {
+            auto* mv = Config::GetMultiview(id);
+            obs_property_list_add_string(list, qt_to_utf8(mv->name), qt_to_utf8(id));
+        }
+        obs_properties_add_int(props, "width", T_MULTIVIEW_SOURCE_WIDTH, 16, 8192, 2);
+        obs_properties_add_int(props, "height", T_MULTIVIEW_SOURCE_HEIGHT, 16, 8192, 2);
+        return props;
+    };
+
+    info.get_width = [](void* data) -> uint32_t {
+        return static_cast<LayoutCompositor*>(data)->Width();
+    };
+
+    info.get_height = [](void* data) -> uint32_t {
+        return static_cast<LayoutCompositor*>(data)->Height();
+    };
+
+    info.video_render = [](void* data, gs_effect_t*) {
+        auto* c = static_cast<LayoutCompositor*>(data);
+        gs_texture_t* tex = c->Texture();
+        if (!tex)
+            return;
+
+        gs_effect_t* effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+        gs_eparam_t* image = gs_effect_get_param_by_name(effect, "image");
+        gs_effect_set_texture(image, tex);
+        while (gs_effect_loop(effect, "Draw"))
+            gs_draw_sprite(tex, 0, c->Width(), c->Height());
+    };
+
+    obs_register_source(&info);
+}
@@ -0,0 +1,100 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#pragma once
+#include "util/resource_usage.hpp"
+#include <QJsonObject>
+#include <QString>
+#include <atomic>
+#include <memory>
+#include <obs-module.h>
+
+class Layout;
+
+// Renders a saved multiview layout headlessly into a texture. The layout is
+// rendered at most once per frame, everything that shows it in that frame
+// samples the same texture. Used by the "durchblick_multiview" video source
+// and by video wall tiles.
+class LayoutCompositor {
+    // Created and changed on the UI thread, rendered on the graphics thread
+    std::atomic<Layout*> m_layout {};
+
+    // UI thread only
+    QJsonObject m_loaded; // Layout data m_layout was built from
+    QString m_multiview_id;
+
+    uint32_t m_tiles_x {}, m_tiles_y {}; // Non-zero if the size follows the base canvas
+
+    // Size of the texture and of the base canvas the layout was built for
+    std::atomic<uint32_t> m_cx { 1920 }, m_cy { 1080 };
+    std::atomic<uint32_t> m_base_cx {}, m_base_cy {};
+    std::atomic<bool> m_reload_queued {};
+    uint64_t m_serial {}; // Set on creation
+
+    // Graphics thread only
+    gs_texrender_t* m_texrender {};
+    uint32_t m_texture_cx {}, m_texture_cy {};
+    TextureTally m_textures;
+    uint64_t m_rendered_frame {};
+    bool m_rendering {};
+
+    void Reload(bool force);
+    void ApplySize(uint32_t cx, uint32_t cy);
+
+public:
+    /// Has to be deleted on the UI thread
+    LayoutCompositor();
+    ~LayoutCompositor();
+
+    /// UI thread only, all of these rebuild the layout. The size is scaled down to what
+    /// fits into a single texture
+    void SetMultiview(QString const& id);
+    void SetSize(uint32_t cx, uint32_t cy);
+    /// Makes the size cols x rows base canvases, also after the base canvas changes
+    void SetTiles(uint32_t cols, uint32_t rows);
+
+    uint32_t Width() const { return m_cx; }
+    uint32_t Height() const { return m_cy; }
+
+    /// Unique per compositor, unlike its address
+    uint64_t Serial() const { return m_serial; }
+
+    /// Renders the layout unless that already happened this frame, graphics thread only.
+    /// Returns nullptr if there's nothing to show
+    gs_texture_t* Texture();
+
+    /// The texture and everything the layout keeps alive, UI thread only
+    void AccountResources(ResourceUsage& usage);
+
+    /// Compositor for a wall of cols x rows base canvas sized tiles showing the multiview,
+    /// shared by everyone asking for the same combination. The last reference can be dropped
+    /// on any thread. UI thread only
+    static std::shared_ptr<LayoutCompositor> SharedWall(QString const& id, uint32_t cols, uint32_t rows);
+
+    /// Registers the source type, called when the module is loaded
+    static void Register();
+
+    /// Picks up changes to saved layouts, UI thread only
+    static void RefreshAll();
+
+    /// Drops all items of all compositors so they don't hold on to sources, UI thread only
+    static void ClearAll();
+
+    /// Logs the resources of multiview sources, then ClearAll() and forgets the shared
+    /// compositors, called when the plugin shuts down
+    static void Shutdown();
+};
@@ -22,8 +22,11 @@
 #include "obs.hpp"
 #include <QApplication>
 #include <QIcon>
+#include <QRegularExpression>
 #include <QWindow>
 #include <obs-module.h>
+#include <util/platform.h>
+#include <util/profiler.hpp>
 
 #ifdef _WIN32
 #    include "../util/windows_helper.hpp"
@@ -156,22 +159,100 @@ void Durchblick::Resize(int cx, int cy)
     m_layout.Resize(m_fw, m_fh, cx, cy);
 }
 
+QString Durchblick::SafeName() const
+{
+    auto* mv = Config::GetMultiviewByWindow(this);
+    QString name = mv ? mv->name : QString("multiview");
+    return name.replace(QRegularExpression("[^\\w\\-]"), "_");
+}
+
+void Durchblick::TakeSnapshot()
+{
+    // Files are named after the multiview
+    m_snapshots.SetOutput(m_snapshot_cfg.directory, SafeName(), m_snapshot_cfg.format);
+    m_snapshots.Request();
+}
+
+void Durchblick::ExportFrameStats()
+{
+    auto file = m_frame_stats.Export(SafeName());
+    if (!file.isEmpty())
+        binfo("Exported frame statistics to '%s'", qt_to_utf8(file));
+}
+
+ResourceUsage Durchblick::Resources()
+{
+    ResourceUsage usage;
+    m_layout.AccountResources(usage);
+    {
+        // Every tile of a wall reports the whole shared texture and layout
+        std::lock_guard<std::mutex> lock(m_wall_mutex);
+        if (m_wall)
+            m_wall->AccountResources(usage);
+    }
+    m_snapshots.AccountResources(usage);
+    m_shm.AccountResources(usage);
+    return usage;
+}
+
+void Durchblick::SetSnapshot(SnapshotConfig const& cfg)
+{
+    m_snapshot_cfg = cfg;
+    m_snapshot_cfg.interval = qBound(0, cfg.interval, 24 * 60 * 60);
+    m_snapshot_cfg.format = cfg.format == "jpg" ? "jpg" : "png";
+
+    if (m_snapshot_cfg.interval > 0)
+        m_snapshot_timer.start(m_snapshot_cfg.interval * 1000);
+    else
+        m_snapshot_timer.stop();
+}
+
+QString Durchblick::ShmName() const
+{
+    return m_shm_cfg.name.isEmpty() ? "/durchblick-" + SafeName() : m_shm_cfg.name;
+}
+
+void Durchblick::SetShm(ShmConfig const& cfg)
+{
+    m_shm_cfg = cfg;
+    m_shm_cfg.format = cfg.format == ShmFrame::NV12 ? ShmFrame::NV12 : ShmFrame::BGRA;
+    m_shm.SetOutput(ShmName(), m_shm_cfg.format, m_shm_cfg.enabled);
+}
+
+void Durchblick::FlushMouseMove()
+{
+    if (!m_pending_move)
+        return;
+    auto e = std::move(m_pending_move);
+    m_layout.MouseMoved(e.get());
+}
+
 void Durchblick::mouseMoveEvent(QMouseEvent* e)
 {
     QWidget::mouseMoveEvent(e);
-    m_layout.MouseMoved(e);
+    // Wall tiles don't show their own layout, there's nothing to interact with
+    if (IsWallTile())
+        return;
+    // Only the latest position matters, it's applied after the next frame was rendered
+    m_pending_move.reset(static_cast<QMouseEvent*>(e->clone()));
+    m_move_pending = true;
 }
 
 void Durchblick::mousePressEvent(QMouseEvent* e)
 {
     QWidget::mousePressEvent(e);
-    m_layout.MousePressed(e);
+    // Clicks are applied right away, but have to see the position the cursor moved to first
+    FlushMouseMove();
+    if (!IsWallTile())
+        m_layout.MousePressed(e);
 }
 
 void Durchblick::mouseReleaseEvent(QMouseEvent* e)
 {
     QWidget::mousePressEvent(e);
-    m_layout.MouseReleased(e);
+    FlushMouseMove();
+    if (!IsWallTile())
+        m_layout.MouseReleased(e);
     if (e->button() == Qt::RightButton) {
         QMenu m(T_MENU_OPTION, this);
         auto* projectorMenu = new QMenu(T_FULLSCREEN);
@@ -194,6 +275,8 @@ void Durchblick::mouseReleaseEvent(QMouseEvent* e)
             m.addAction(always_on_top);
         }
 
+        m.addAction(T_MENU_SNAPSHOT, this, SLOT(TakeSnapshot()));
+        m.addAction(T_MENU_FRAME_STATS, this, SLOT(ExportFrameStats()));
         m_layout.HandleContextMenu(e, m);
         m.exec(QCursor::pos());
     }
@@ -202,7 +285,17 @@ void Durchblick::mouseReleaseEvent(QMouseEvent* e)
 void Durchblick::mouseDoubleClickEvent(QMouseEvent* e)
 {
     QWidget::mouseDoubleClickEvent(e);
-    m_layout.MouseDoubleClicked(e);
+    FlushMouseMove();
+    if (!IsWallTile())
+        m_layout.MouseDoubleClicked(e);
+}
+
+void Durchblick::wheelEvent(QWheelEvent* e)
+{
+    QWidget::wheelEvent(e);
+    FlushMouseMove();
+    if (!IsWallTile())
+        m_layout.MouseWheel(e);
 }
 
 void Durchblick::contextMenuEvent(QContextMenuEvent*)
@@ -215,6 +308,14 @@ void Durchblick::closeEvent(QCloseEvent* e)
     OnClose();
     Config::Save();
     m_layout.DeleteLayout();
+    {
+        // Reacquired when the window is shown and loads its layout again
+        std::lock_guard<std::mutex> lock(m_wall_mutex);
+        m_wall.reset();
+    }
+    m_snapshot_timer.stop();
+    // Readers see the segment closing instead of a frozen frame, showing the window opens it again
+    m_shm.SetOutput(ShmName(), m_shm_cfg.format, false);
     hide();
     DeleteDisplay();
 }
@@ -282,6 +383,7 @@ Durchblick::Durchblick(QWidget* widget, Qt::WindowType t)
     connect(qApp, &QGuiApplication::screenRemoved, this,
         &Durchblick::ScreenRemoved);
     connect(this, &OBSQTDisplay::DisplayResized, this, &Durchblick::Resize);
+    connect(&m_snapshot_timer, &QTimer::timeout, this, &Durchblick::TakeSnapshot);
 
     m_ready = true;
 
@@ -316,20 +418,92 @@ void Durchblick::OnClose()
 
 void Durchblick::RenderLayout(void* data, uint32_t cx, uint32_t cy)
 {
+    ProfileScope("Durchblick::RenderLayout");
     auto* w = (Durchblick*)data;
-    if (!w->m_ready)
-        return;
+
+    // Hand the latest mouse move of this frame to the UI thread, at most one flush is in flight
+    if (w->m_move_pending.exchange(false))
+        QMetaObject::invokeMethod(w, [w]() { w->FlushMouseMove(); }, Qt::QueuedConnection);
 
     // For embedded widgets (docked mode), check parent visibility
     // For standalone windows, check own visibility
-    if (w->parentWidget()) {
-        if (!w->parentWidget()->isVisible())
-            return;
-    } else if (!w->isVisible()) {
+    bool visible = w->parentWidget() ? w->parentWidget()->isVisible() : w->isVisible();
+    if (!w->m_ready || !visible) {
+        w->m_frame_stats.Pause();
         return;
     }
+    const uint64_t frame_start = os_gettime_ns();
+
+    std::shared_ptr<LayoutCompositor> wall;
+    WallConfig tile;
+    {
+        std::lock_guard<std::mutex> lock(w->m_wall_mutex);
+        wall = w->m_wall;
+        tile = w->m_wall_tile;
+    }
 
-    w->m_layout.Render(w->m_fw, w->m_fh, cx, cy);
+    // Published and snapshot frames are drawn into a texture first, which is then shown as
+    // usual. A snapshot capture ends up nested inside the shared memory capture
+    bool publish = w->m_shm.BeginCapture(cx, cy);
+    bool capture = w->m_snapshots.BeginCapture(cx, cy);
+    uint32_t items = 0; // A wall tile only copies from the shared texture
+    if (wall) {
+        RenderWallTile(*wall, tile, cx, cy);
+    } else {
+        w->m_layout.Render(w->m_fw, w->m_fh, cx, cy);
+        items = w->m_layout.RenderedItems();
+    }
+    if (capture)
+        w->m_snapshots.EndCapture();
+    if (publish)
+        w->m_shm.EndCapture();
+    w->m_snapshots.Poll();
+    w->m_shm.Poll();
+
+    w->m_frame_stats.Record(frame_start, os_gettime_ns(), items);
+}
+
+void Durchblick::RenderWallTile(LayoutCompositor& wall, WallConfig const& tile, uint32_t cx, uint32_t cy)
+{
+    // Whichever tile is drawn first this frame renders the whole wall
+    gs_texture_t* tex = wall.Texture();
+    if (!tex)
+        return;
+
+    const uint32_t tile_cx = wall.Width() / tile.cols;
+    const uint32_t tile_cy = wall.Height() / tile.rows;
+
+    gs_projection_push();
+    gs_viewport_push();
+    gs_set_viewport(0, 0, cx, cy);
+    gs_ortho(0.0f, float(tile_cx), 0.0f, float(tile_cy), -100.0f, 100.0f);
+
+    gs_effect_t* effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+    gs_eparam_t* image = gs_effect_get_param_by_name(effect, "image");
+    gs_effect_set_texture(image, tex);
+    while (gs_effect_loop(effect, "Draw"))
+        gs_draw_sprite_subregion(tex, 0, tile.col * tile_cx, tile.row * tile_cy, tile_cx, tile_cy);
+
+    gs_viewport_pop();
+    gs_projection_pop();
+}
+
+void Durchblick::SetWall(WallConfig const& cfg)
+{
+    m_wall_cfg = cfg;
+    m_wall_cfg.cols = qBound(1, cfg.cols, 8);
+    m_wall_cfg.rows = qBound(1, cfg.rows, 8);
+    m_wall_cfg.col = qBound(0, cfg.col, m_wall_cfg.cols - 1);
+    m_wall_cfg.row = qBound(0, cfg.row, m_wall_cfg.rows - 1);
+
+    // Every tile is as big as the base canvas, all tiles of a wall share one compositor
+    std::shared_ptr<LayoutCompositor> wall;
+    if (IsWallTile())
+        wall = LayoutCompositor::SharedWall(m_wall_cfg.multiview, m_wall_cfg.cols, m_wall_cfg.rows);
+
+    std::lock_guard<std::mutex> lock(m_wall_mutex);
+    m_wall = std::move(wall);
+    m_wall_tile = m_wall_cfg;
 }
 
 void Durchblick::SetMonitor(int monitor)
@@ -380,6 +554,25 @@ void Durchblick::Save(QJsonObject& obj)
         obj["hide_from_display_capture"] = GetHideFromDisplayCapture();
         obj["hide_cursor"] = m_hide_cursor;
         obj["always_on_top"] = m_always_on_top;
+        if (IsWallTile()) {
+            QJsonObject wall;
+            wall["multiview"] = m_wall_cfg.multiview;
+            wall["cols"] = m_wall_cfg.cols;
+            wall["rows"] = m_wall_cfg.rows;
+            wall["col"] = m_wall_cfg.col;
+            wall["row"] = m_wall_cfg.row;
+            obj["wall"] = wall;
+        }
+        QJsonObject snapshot;
+        snapshot["interval"] = m_snapshot_cfg.interval;
+        snapshot["format"] = m_snapshot_cfg.format;
+        snapshot["directory"] = m_snapshot_cfg.directory;
+        obj["snapshot"] = snapshot;
+        QJsonObject shm;
+        shm["enabled"] = m_shm_cfg.enabled;
+        shm["name"] = m_shm_cfg.name;
+        shm["format"] = m_shm_cfg.format == ShmFrame::NV12 ? "nv12" : "bgra";
+        obj["shm"] = shm;
         m_layout.Save(obj);
         m_cached_layout = obj;
     } else {
@@ -426,6 +619,29 @@ void Durchblick::Load(QJsonObject const& obj)
 
     SetHideFromDisplayCapture(obj["hide_from_display_capture"].toBool(false));
     m_layout.Load(obj);
+
+    auto wall = obj["wall"].toObject();
+    WallConfig cfg;
+    cfg.multiview = wall["multiview"].toString();
+    cfg.cols = wall["cols"].toInt(2);
+    cfg.rows = wall["rows"].toInt(2);
+    cfg.col = wall["col"].toInt(0);
+    cfg.row = wall["row"].toInt(0);
+    SetWall(cfg);
+
+    auto snapshot = obj["snapshot"].toObject();
+    SnapshotConfig snapshot_cfg;
+    snapshot_cfg.interval = snapshot["interval"].toInt(0);
+    snapshot_cfg.format = snapshot["format"].toString("png");
+    snapshot_cfg.directory = snapshot["directory"].toString();
+    SetSnapshot(snapshot_cfg);
+
+    auto shm = obj["shm"].toObject();
+    ShmConfig shm_cfg;
+    shm_cfg.enabled = shm["enabled"].toBool(false);
+    shm_cfg.name = shm["name"].toString();
+    shm_cfg.format = shm["format"].toString() == "nv12" ? ShmFrame::NV12 : ShmFrame::BGRA;
+    SetShm(shm_cfg);
 }
 
 void Durchblick::SetHideFromDisplayCapture(bool hide_from_display_capture)
@@ -17,16 +17,44 @@
  *************************************************************************/
 #pragma once
 #include "../layout.hpp"
+#include "../layout_compositor.hpp"
+#include "../util/frame_stats.hpp"
+#include "../util/shm_output.hpp"
+#include "../util/snapshot_exporter.hpp"
 #include "qt_display.hpp"
 #include <QRect>
 #include <QScreen>
 #include <QTimer>
 #include <QVBoxLayout>
 #include <QWindow>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <obs-frontend-api.h>
 
 class Durchblick : public OBSQTDisplay {
     Q_OBJECT
+public:
+    // In video wall mode a window shows one tile of another multiview, which is
+    // rendered once per frame for all tiles instead of this window's own layout
+    struct WallConfig {
+        QString multiview; // Empty if this window isn't a wall tile
+        int cols { 2 }, rows { 2 }, col {}, row {};
+    };
+
+    struct SnapshotConfig {
+        int interval {}; // Seconds between snapshots, 0 to only take them from the context menu
+        QString format { "png" };
+        QString directory; // Empty for the plugin config folder
+    };
+
+    struct ShmConfig {
+        bool enabled {};
+        QString name; // Empty to derive it from the multiview name
+        ShmFrame::Format format { ShmFrame::BGRA };
+    };
+
+private:
 
     enum WindowState {
         None,
@@ -45,6 +73,32 @@ class Durchblick : public OBSQTDisplay {
 
     QJsonObject m_cached_layout {};
 
+    // Mouse moves are coalesced and applied once per rendered frame, so high polling rate
+    // mice don't dispatch hundreds of moves (and fader changes) per second to the layout
+    std::unique_ptr<QMouseEvent> m_pending_move; // UI thread only
+    std::atomic<bool> m_move_pending { false };
+
+    void FlushMouseMove();
+
+    WallConfig m_wall_cfg; // UI thread
+    std::mutex m_wall_mutex;
+    std::shared_ptr<LayoutCompositor> m_wall; // Guarded by m_wall_mutex
+    WallConfig m_wall_tile;                   // Guarded by m_wall_mutex
+
+    static void RenderWallTile(LayoutCompositor& wall, WallConfig const& tile, uint32_t cx, uint32_t cy);
+
+    SnapshotConfig m_snapshot_cfg;
+    SnapshotExporter m_snapshots;
+    QTimer m_snapshot_timer;
+
+    ShmConfig m_shm_cfg;
+    ShmOutput m_shm;
+
+    FrameStats m_frame_stats;
+
+    /// Multiview name without characters that aren't allowed in file names
+    QString SafeName() const;
+
 public:
     QRect m_previous_geometry;
     bool m_ready { false }, m_has_size { false };
@@ -61,12 +115,15 @@ private slots:
     void AlwaysOnTopToggled(bool alwaysOnTop);
     void ScreenRemoved(QScreen* screen_);
     void Resize(int cx, int cy);
+    void TakeSnapshot();
+    void ExportFrameStats();
 
 protected:
     virtual void mouseMoveEvent(QMouseEvent*) override;
     virtual void mousePressEvent(QMouseEvent*) override;
     virtual void mouseReleaseEvent(QMouseEvent*) override;
     virtual void mouseDoubleClickEvent(QMouseEvent*) override;
+    virtual void wheelEvent(QWheelEvent*) override;
     virtual void contextMenuEvent(QContextMenuEvent*) override;
 
     virtual void closeEvent(QCloseEvent*) override;
@@ -96,6 +153,9 @@ public:
     /// Will either load fromt he JSON object or create the default layout
     void Load(QJsonObject const& obj);
 
+    /// Layout as of the last Save() or Load(), without serializing it again
+    QJsonObject const& SavedLayout() const { return m_cached_layout; }
+
     void SetHideFromDisplayCapture(bool hide_from_display_capture);
 
     bool GetHideFromDisplayCapture()
@@ -113,9 +173,23 @@ public:
     }
 
     bool GetIsCursorHidden() const { return m_hide_cursor; }
+
+    void SetWall(WallConfig const& cfg);
+    WallConfig const& GetWall() const { return m_wall_cfg; }
+    bool IsWallTile() const { return !m_wall_cfg.multiview.isEmpty(); }
     bool HasSize() const { return m_has_size; }
 
+    void SetSnapshot(SnapshotConfig const& cfg);
+    SnapshotConfig const& GetSnapshot() const { return m_snapshot_cfg; }
+
+    void SetShm(ShmConfig const& cfg);
+    ShmConfig const& GetShm() const { return m_shm_cfg; }
+    QString ShmName() const;
+
     Layout* GetLayout() { return &m_layout; }
 
+    /// UI thread, everything this multiview and its layout keep alive
+    ResourceUsage Resources();
+
     void SetWidgetVisibility(bool v);
 };
@@ -21,6 +21,9 @@
 #include "../layout.hpp"
 #include "../util/util.h"
 #include "durchblick.hpp"
+#include <QFileDialog>
+#include <QFormLayout>
+#include <QGroupBox>
 #include <QHBoxLayout>
 #include <QPushButton>
 
@@ -35,6 +38,28 @@ void LayoutConfigDialog::OKClicked()
 #endif
 
     m_durchblick->SetHideCursor(m_hide_cursor->isChecked());
+
+    Durchblick::WallConfig wall;
+    wall.multiview = m_wall_multiview->currentData().toString();
+    wall.cols = m_wall_cols->value();
+    wall.rows = m_wall_rows->value();
+    wall.col = m_wall_col->value() - 1;
+    wall.row = m_wall_row->value() - 1;
+    m_durchblick->SetWall(wall);
+
+    Durchblick::SnapshotConfig snapshot;
+    snapshot.interval = m_snapshot_interval->value();
+    snapshot.format = m_snapshot_format->currentData().toString();
+    snapshot.directory = m_snapshot_directory->text();
+    m_durchblick->SetSnapshot(snapshot);
+
+#if !defined(_WIN32)
+    Durchblick::ShmConfig shm;
+    shm.enabled = m_shm->isChecked();
+    shm.name = m_shm_name->text().trimmed();
+    shm.format = ShmFrame::Format(m_shm_format->currentData().toUInt());
+    m_durchblick->SetShm(shm);
+#endif
     Config::Save();
     hide();
 }
@@ -80,6 +105,87 @@ LayoutConfigDialog::LayoutConfigDialog(Durchblick* parent, Layout* layout)
     m_hide_cursor->setChecked(m_durchblick->GetIsCursorHidden());
     m_vboxlayout->addWidget(m_hide_cursor);
 
+    // Video wall, this window can show a tile of another multiview instead of its own layout
+    auto const& wall = m_durchblick->GetWall();
+    auto* wall_box = new QGroupBox(T_LABEL_WALL, this);
+    auto* wall_form = new QFormLayout(wall_box);
+    m_wall_multiview = new QComboBox(wall_box);
+    m_wall_multiview->addItem(T_LABEL_WALL_NONE, QString());
+    auto* self = Config::GetMultiviewByWindow(m_durchblick);
+    for (auto const& id : Config::GetMultiviewIds()) {
+        auto* mv = Config::GetMultiview(id);
+        if (mv == self)
+            continue;
+        m_wall_multiview->addItem(mv->name, id);
+        if (id == wall.multiview)
+            m_wall_multiview->setCurrentIndex(m_wall_multiview->count() - 1);
+    }
+    wall_form->addRow(T_LABEL_WALL_MULTIVIEW, m_wall_multiview);
+
+    auto add_pair = [&](char const* label, QSpinBox*& a, QSpinBox*& b, int va, int vb) {
+        auto* row = new QHBoxLayout();
+        a = new QSpinBox(wall_box);
+        b = new QSpinBox(wall_box);
+        a->setRange(1, 8);
+        b->setRange(1, 8);
+        a->setValue(va);
+        b->setValue(vb);
+        row->addWidget(a);
+        row->addWidget(new QLabel("x", wall_box));
+        row->addWidget(b);
+        wall_form->addRow(label, row);
+    };
+    add_pair(T_LABEL_WALL_SIZE, m_wall_cols, m_wall_rows, wall.cols, wall.rows);
+    add_pair(T_LABEL_WALL_TILE, m_wall_col, m_wall_row, wall.col + 1, wall.row + 1);
+    m_vboxlayout->addWidget(wall_box);
+
+    auto const& snapshot = m_durchblick->GetSnapshot();
+    auto* snapshot_box = new QGroupBox(T_LABEL_SNAPSHOT, this);
+    auto* snapshot_form = new QFormLayout(snapshot_box);
+    m_snapshot_interval = new QSpinBox(snapshot_box);
+    m_snapshot_interval->setRange(0, 24 * 60 * 60);
+    m_snapshot_interval->setSuffix(" s");
+    m_snapshot_interval->setSpecialValueText(T_LABEL_SNAPSHOT_OFF);
+    m_snapshot_interval->setValue(snapshot.interval);
+    snapshot_form->addRow(T_LABEL_SNAPSHOT_INTERVAL, m_snapshot_interval);
+
+    m_snapshot_format = new QComboBox(snapshot_box);
+    m_snapshot_format->addItem("PNG", "png");
+    m_snapshot_format->addItem("JPEG", "jpg");
+    m_snapshot_format->setCurrentIndex(snapshot.format == "jpg" ? 1 : 0);
+    snapshot_form->addRow(T_LABEL_SNAPSHOT_FORMAT, m_snapshot_format);
+
+    auto* directory_row = new QHBoxLayout();
+    m_snapshot_directory = new QLineEdit(snapshot.directory, snapshot_box);
+    auto* browse = new QPushButton("...", snapshot_box);
+    connect(browse, &QPushButton::clicked, this, [this]() {
+        auto dir = QFileDialog::getExistingDirectory(this, T_LABEL_SNAPSHOT_DIRECTORY, m_snapshot_directory->text());
+        if (!dir.isEmpty())
+            m_snapshot_directory->setText(dir);
+    });
+    directory_row->addWidget(m_snapshot_directory);
+    directory_row->addWidget(browse);
+    snapshot_form->addRow(T_LABEL_SNAPSHOT_DIRECTORY, directory_row);
+    m_vboxlayout->addWidget(snapshot_box);
+
+#if !defined(_WIN32)
+    // Frames for other processes on this machine, see shm_frame.hpp
+    auto const& shm = m_durchblick->GetShm();
+    m_shm = new QGroupBox(T_LABEL_SHM, this);
+    m_shm->setCheckable(true);
+    m_shm->setChecked(shm.enabled);
+    auto* shm_form = new QFormLayout(m_shm);
+    m_shm_name = new QLineEdit(shm.name, m_shm);
+    m_shm_name->setPlaceholderText(m_durchblick->ShmName());
+    shm_form->addRow(T_LABEL_SHM_NAME, m_shm_name);
+    m_shm_format = new QComboBox(m_shm);
+    m_shm_format->addItem("BGRA", uint(ShmFrame::BGRA));
+    m_shm_format->addItem("NV12", uint(ShmFrame::NV12));
+    m_shm_format->setCurrentIndex(shm.format == ShmFrame::NV12 ? 1 : 0);
+    shm_form->addRow(T_LABEL_SHM_FORMAT, m_shm_format);
+    m_vboxlayout->addWidget(m_shm);
+#endif
+
     m_button_box = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this);
     m_vboxlayout->addWidget(m_button_box);
     setLayout(m_vboxlayout);
@@ -22,7 +22,9 @@
 #include <QComboBox>
 #include <QDialog>
 #include <QDialogButtonBox>
+#include <QGroupBox>
 #include <QLabel>
+#include <QLineEdit>
 #include <QSpinBox>
 #include <QVBoxLayout>
 
@@ -35,6 +37,14 @@ class LayoutConfigDialog : public QDialog {
     QDialogButtonBox* m_button_box {};
     QSpinBox *m_cols {}, *m_rows {};
     QCheckBox *m_hide_from_display_capture {}, *m_hide_cursor {};
+    QComboBox* m_wall_multiview {};
+    QSpinBox *m_wall_cols {}, *m_wall_rows {}, *m_wall_col {}, *m_wall_row {};
+    QSpinBox* m_snapshot_interval {};
+    QComboBox* m_snapshot_format {};
+    QLineEdit* m_snapshot_directory {};
+    QGroupBox* m_shm {};
+    QLineEdit* m_shm_name {};
+    QComboBox* m_shm_format {};
     Layout* m_layout {};
     Durchblick* m_durchblick {};
 private slots:
@@ -131,6 +131,9 @@ void ManageMultiviewsDialog::OnSelectionChanged()
     m_rename_button->setEnabled(hasSelection);
     m_delete_button->setEnabled(hasSelection);
     m_duplicate_button->setEnabled(hasSelection);
+
+    auto* mv = hasSelection ? Config::GetMultiview(m_multiview_list->currentItem()->data(Qt::UserRole).toString()) : nullptr;
+    m_resources->setText(mv && mv->window ? mv->window->Resources().Summary() : QString());
 }
 
 void ManageMultiviewsDialog::RefreshList()
@@ -167,6 +170,11 @@ ManageMultiviewsDialog::ManageMultiviewsDialog(QWidget* parent)
     m_multiview_list = new QListWidget(this);
     mainLayout->addWidget(m_multiview_list);
 
+    m_resources = new QLabel(this);
+    m_resources->setWordWrap(true);
+    m_resources->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    mainLayout->addWidget(m_resources);
+
     // Button layout
     auto* buttonLayout = new QHBoxLayout();
 
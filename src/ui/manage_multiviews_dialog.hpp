@@ -19,6 +19,7 @@
 #pragma once
 
 #include <QDialog>
+#include <QLabel>
 #include <QListWidget>
 #include <QPushButton>
 #include <QVBoxLayout>
@@ -27,6 +28,7 @@ class ManageMultiviewsDialog : public QDialog {
     Q_OBJECT
 
     QListWidget* m_multiview_list;
+    QLabel* m_resources; // What the selected multiview keeps alive
     QPushButton* m_show_button;
     QPushButton* m_rename_button;
     QPushButton* m_delete_button;
@@ -0,0 +1,115 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "audio_tap.hpp"
+#include "util.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+AudioTap::AudioTap(AudioConsumer* consumer)
+    : m_consumer(consumer)
+{
+    // The audio format is fixed until OBS restarts its audio subsystem, which recreates all sources
+    audio_t* audio = obs_get_audio();
+    m_channels = std::max<uint32_t>(1, std::min<uint32_t>(audio_output_get_channels(audio), MAX_AUDIO_CHANNELS));
+    m_sample_rate = audio_output_get_sample_rate(audio);
+    obs_audio_info oai;
+    if (obs_get_audio_info(&oai))
+        m_speakers = oai.speakers;
+
+    m_ring.resize(size_t(RING_FRAMES) * m_channels);
+    m_worker = std::thread([this] { Run(); });
+}
+
+AudioTap::~AudioTap()
+{
+    SetSource(nullptr);
+    m_running = false;
+    m_worker.join();
+
+    if (m_dropped > 0)
+        bdebug("Audio tap dropped %llu frames because its worker fell behind", (unsigned long long)m_dropped.load());
+}
+
+void AudioTap::SetSource(obs_source_t* src)
+{
+    std::lock_guard<std::mutex> lock(m_source_mutex);
+    if (src == m_source)
+        return;
+    // Once removed the callback is guaranteed not to run anymore
+    if (m_source)
+        obs_source_remove_audio_capture_callback(m_source, Capture, this);
+    m_source = src;
+    m_restart = true;
+    if (m_source)
+        obs_source_add_audio_capture_callback(m_source, Capture, this);
+}
+
+OBSSource AudioTap::Source()
+{
+    std::lock_guard<std::mutex> lock(m_source_mutex);
+    return m_source;
+}
+
+void AudioTap::Capture(void* param, obs_source_t*, audio_data const* audio, bool)
+{
+    auto* tap = static_cast<AudioTap*>(param);
+    const uint64_t write = tap->m_write.load(std::memory_order_relaxed);
+    const uint64_t read = tap->m_read.load(std::memory_order_acquire);
+    const uint32_t frames = audio->frames;
+
+    if (write - read + frames > RING_FRAMES) {
+        tap->m_dropped.fetch_add(frames, std::memory_order_relaxed);
+        return;
+    }
+
+    // Planar to interleaved, nothing else happens on the audio thread
+    const uint32_t channels = tap->m_channels;
+    float* ring = tap->m_ring.data();
+    for (uint32_t c = 0; c < channels; c++) {
+        auto const* in = reinterpret_cast<float const*>(audio->data[c]);
+        uint64_t pos = write;
+        for (uint32_t f = 0; f < frames; f++, pos++)
+            ring[(pos & (RING_FRAMES - 1)) * channels + c] = in ? in[f] : 0.f;
+    }
+    tap->m_write.store(write + frames, std::memory_order_release);
+}
+
+void AudioTap::Run()
+{
+    while (m_running) {
+        if (m_restart.exchange(false)) {
+            // Whatever is left belongs to the previous source
+            m_read.store(m_write.load(std::memory_order_acquire), std::memory_order_release);
+            m_consumer->Reset(m_channels, m_sample_rate, m_speakers);
+        }
+
+        uint64_t read = m_read.load(std::memory_order_relaxed);
+        const uint64_t write = m_write.load(std::memory_order_acquire);
+        while (read < write) {
+            // Hand out contiguous parts of the ring, so the consumer reads it in place
+            const uint64_t offset = read & (RING_FRAMES - 1);
+            const uint32_t frames = uint32_t(std::min<uint64_t>(write - read, RING_FRAMES - offset));
+            m_consumer->Process(m_ring.data() + offset * m_channels, frames);
+            read += frames;
+            m_read.store(read, std::memory_order_release);
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
@@ -0,0 +1,73 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <obs.hpp>
+#include <thread>
+#include <vector>
+
+// Receives the audio of a source on a worker thread, see AudioTap
+class AudioConsumer {
+public:
+    virtual ~AudioConsumer() = default;
+
+    /// Called before the first block of a source, and whenever the tap switched sources
+    virtual void Reset(uint32_t channels, uint32_t sample_rate, speaker_layout speakers) = 0;
+
+    /// Interleaved float samples
+    virtual void Process(float const* samples, uint32_t frames) = 0;
+};
+
+// Taps the audio of a source through an audio capture callback. The audio
+// thread only copies the samples into a single producer, single consumer ring,
+// a worker thread drains it every few milliseconds and hands the samples to
+// the consumer. If the worker falls behind new samples are dropped, the audio
+// thread never waits.
+class AudioTap {
+    static constexpr uint32_t RING_FRAMES = 1 << 16; // ~1.3 seconds at 48 kHz
+
+    AudioConsumer* m_consumer;
+    uint32_t m_channels {}, m_sample_rate {};
+    speaker_layout m_speakers { SPEAKERS_STEREO };
+
+    std::vector<float> m_ring; // Interleaved, RING_FRAMES * m_channels
+    std::atomic<uint64_t> m_write {}, m_read {};
+    std::atomic<uint64_t> m_dropped {};
+
+    std::mutex m_source_mutex;
+    OBSSource m_source; // Guarded by m_source_mutex, UI thread writes
+    std::atomic<bool> m_restart { true };
+
+    std::atomic<bool> m_running { true };
+    std::thread m_worker;
+
+    static void Capture(void* param, obs_source_t* source, audio_data const* audio, bool muted);
+    void Run();
+
+public:
+    explicit AudioTap(AudioConsumer* consumer);
+    ~AudioTap();
+
+    /// UI thread, nullptr detaches
+    void SetSource(obs_source_t* src);
+    OBSSource Source();
+
+    uint64_t Dropped() const { return m_dropped; }
+};
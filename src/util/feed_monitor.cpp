@@ -0,0 +1,219 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "feed_monitor.hpp"
+#include <cstdlib>
+#include <cstring>
+
+#define SAMPLES_PER_FRAME 4 // Across all monitors
+
+#define BLACK_LUMA 20
+#define BLACK_VARIANCE 20
+#define CLIP_LUMA 250
+#define CLIP_FRACTION 0.4f
+#define FREEZE_TOLERANCE 0.5f // Mean absolute difference of the grid in luma steps
+
+#define BLACK_DELAY 2000000000ull
+#define FROZEN_DELAY 5000000000ull
+#define CLIPPED_DELAY 2000000000ull
+
+static_assert(FeedMonitor::SAMPLE_CX % FeedMonitor::GRID_CX == 0 && FeedMonitor::SAMPLE_CY % FeedMonitor::GRID_CY == 0,
+    "Grid cells have to cover whole sample pixels");
+
+// Graphics thread only
+static uint64_t budget_frame {};
+static int budget_used {};
+
+static bool TakeBudget()
+{
+    auto frame = obs_get_video_frame_time();
+    if (frame != budget_frame) {
+        budget_frame = frame;
+        budget_used = 0;
+    }
+    if (budget_used >= SAMPLES_PER_FRAME)
+        return false;
+    budget_used++;
+    return true;
+}
+
+FeedMonitor::~FeedMonitor()
+{
+    obs_enter_graphics();
+    gs_texrender_destroy(m_cell);
+    obs_leave_graphics();
+}
+
+void FeedMonitor::Reset()
+{
+    m_ring.Discard();
+    m_has_previous = false;
+    m_black_since = m_frozen_since = m_clipped_since = 0;
+    m_alarm = Alarm::None;
+}
+
+bool FeedMonitor::BeginCell(uint32_t cx, uint32_t cy, uint32_t cell_cx, uint32_t cell_cy)
+{
+    if (!m_enabled || cx == 0 || cy == 0 || cell_cx == 0 || cell_cy == 0)
+        return false;
+
+    if (!m_cell)
+        m_cell = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+    gs_texrender_reset(m_cell);
+    if (!gs_texrender_begin(m_cell, cell_cx, cell_cy))
+        return false;
+    m_textures.Resize(m_cell_cx, m_cell_cy, cell_cx, cell_cy, 4);
+
+    vec4 clear_color;
+    vec4_zero(&clear_color);
+    gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
+    gs_ortho(0.0f, float(cx), 0.0f, float(cy), -100.0f, 100.0f);
+    gs_matrix_push();
+    gs_matrix_identity();
+    gs_blend_state_push();
+    gs_blend_function_separate(GS_BLEND_SRCALPHA, GS_BLEND_INVSRCALPHA, GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+    return true;
+}
+
+gs_texture_t* FeedMonitor::EndCell()
+{
+    gs_blend_state_pop();
+    gs_matrix_pop();
+    gs_texrender_end(m_cell);
+    gs_texture_t* tex = gs_texrender_get_texture(m_cell);
+    if (tex && m_tick >= m_next_sample)
+        Sample(tex);
+    return tex;
+}
+
+void FeedMonitor::Sample(gs_texture_t* tex)
+{
+    // Out of surfaces or out of budget this frame, try again on the next one
+    StagingRing::Slot* slot = m_ring.Acquire(SAMPLE_CX, SAMPLE_CY);
+    if (!slot || !TakeBudget())
+        return;
+
+    // Scaling the cell image down is a single quad
+    if (m_ring.BeginRender(SAMPLE_CX, SAMPLE_CY, m_cell_cx, m_cell_cy)) {
+        DrawCell(tex, m_cell_cx, m_cell_cy);
+        m_ring.Stage(slot, m_ring.EndRender());
+        m_next_sample = m_tick + SAMPLE_INTERVAL;
+    }
+}
+
+void FeedMonitor::DrawCell(gs_texture_t* tex, uint32_t cx, uint32_t cy)
+{
+    gs_blend_state_push();
+    gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+    gs_effect_t* effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+    gs_eparam_t* image = gs_effect_get_param_by_name(effect, "image");
+    gs_effect_set_texture(image, tex);
+    while (gs_effect_loop(effect, "Draw"))
+        gs_draw_sprite(tex, 0, cx, cy);
+    gs_blend_state_pop();
+}
+
+void FeedMonitor::Poll()
+{
+    if (m_restart.exchange(false) || !m_enabled) {
+        if (m_has_previous || m_alarm != Alarm::None)
+            Reset();
+        if (!m_enabled)
+            return;
+    }
+
+    m_ring.Poll([this](StagingRing::Slot& slot) {
+        Analyze(slot.data[0], slot.linesize[0], slot.timestamp);
+        return false;
+    });
+    m_tick++;
+}
+
+void FeedMonitor::Analyze(uint8_t const* data, uint32_t linesize, uint64_t ts)
+{
+    constexpr uint32_t block_cx = SAMPLE_CX / GRID_CX, block_cy = SAMPLE_CY / GRID_CY;
+    constexpr uint32_t pixels = SAMPLE_CX * SAMPLE_CY;
+
+    uint32_t sums[GRID_CX * GRID_CY] {};
+    uint64_t total = 0, total_sq = 0;
+    uint32_t clipped = 0;
+
+    for (uint32_t y = 0; y < SAMPLE_CY; y++) {
+        auto const* row = data + size_t(y) * linesize;
+        auto* grid_row = sums + (y / block_cy) * GRID_CX;
+        for (uint32_t x = 0; x < SAMPLE_CX; x++) {
+            auto const* px = row + x * 4;
+            // BT.709 weights in 8 bit fixed point, pixels are BGRA
+            uint32_t luma = (px[2] * 54 + px[1] * 183 + px[0] * 19) >> 8;
+            total += luma;
+            total_sq += luma * luma;
+            clipped += luma >= CLIP_LUMA;
+            grid_row[x / block_cx] += luma;
+        }
+    }
+
+    const float mean = float(total) / pixels;
+    const float variance = float(total_sq) / pixels - mean * mean;
+
+    uint8_t grid[GRID_CX * GRID_CY];
+    uint64_t hash = 14695981039346656037ull; // FNV-1a
+    for (uint32_t i = 0; i < GRID_CX * GRID_CY; i++) {
+        grid[i] = uint8_t(sums[i] / (block_cx * block_cy));
+        hash = (hash ^ grid[i]) * 1099511628211ull;
+    }
+
+    bool same = false;
+    if (m_has_previous) {
+        same = hash == m_hash;
+        if (!same) {
+            // Noise from analog sources or encoders keeps the hash changing on a still picture
+            uint32_t diff = 0;
+            for (uint32_t i = 0; i < GRID_CX * GRID_CY; i++)
+                diff += uint32_t(abs(int(grid[i]) - int(m_grid[i])));
+            same = float(diff) / (GRID_CX * GRID_CY) < FREEZE_TOLERANCE;
+        }
+    }
+    memcpy(m_grid, grid, sizeof(grid));
+    m_hash = hash;
+    m_has_previous = true;
+
+    // A condition only raises the alarm once it held for a while, it clears right away
+    auto held = [ts](uint64_t& since, bool condition, uint64_t delay) {
+        if (!condition) {
+            since = 0;
+            return false;
+        }
+        if (!since)
+            since = ts;
+        return ts - since >= delay;
+    };
+
+    bool black = held(m_black_since, mean < BLACK_LUMA && variance < BLACK_VARIANCE, BLACK_DELAY);
+    bool frozen = held(m_frozen_since, same, FROZEN_DELAY);
+    bool clip = held(m_clipped_since, clipped > pixels * CLIP_FRACTION, CLIPPED_DELAY);
+
+    // A black picture is also a still one, report the more specific problem
+    Alarm alarm = Alarm::None;
+    if (black)
+        alarm = Alarm::Black;
+    else if (frozen)
+        alarm = Alarm::Frozen;
+    else if (clip)
+        alarm = Alarm::Clipped;
+
+    m_alarm = alarm;
+}
@@ -0,0 +1,95 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#pragma once
+#include "resource_usage.hpp"
+#include "staging_ring.hpp"
+#include <atomic>
+#include <cstdint>
+#include <obs-module.h>
+
+// Watches a video feed for black, frozen or clipped pictures. While it is enabled
+// the cell renders its source into a texture at its own size and always shows that,
+// so the source is still only rendered once. Every few frames the texture is scaled
+// down to a tiny sample and read back through a StagingRing, so the GPU is never waited on.
+// The CPU side only looks at a 16x9 luma grid and a hash of it. How many feeds
+// are sampled per frame is capped across all monitors, so many cells only
+// lower the rate at which each one is checked.
+class FeedMonitor {
+public:
+    enum class Alarm {
+        None,
+        Black,
+        Frozen,
+        Clipped,
+    };
+
+    static constexpr uint32_t SAMPLE_CX = 64, SAMPLE_CY = 36;
+    static constexpr uint32_t GRID_CX = 16, GRID_CY = 9;
+
+private:
+    static constexpr uint64_t SAMPLE_INTERVAL = 6; // Polls between two samples of this feed
+
+    // Graphics thread only
+    StagingRing m_ring;
+    gs_texrender_t* m_cell {}; // What the cell shows while monitoring
+    uint32_t m_cell_cx {}, m_cell_cy {};
+    TextureTally m_textures;
+    uint64_t m_tick {}, m_next_sample {};
+
+    uint8_t m_grid[GRID_CX * GRID_CY] {};
+    uint64_t m_hash {};
+    bool m_has_previous {};
+    uint64_t m_black_since {}, m_frozen_since {}, m_clipped_since {}; // 0 while the condition isn't met
+
+    std::atomic<bool> m_enabled { false };
+    std::atomic<bool> m_restart { false };
+    std::atomic<Alarm> m_alarm { Alarm::None };
+
+    void Analyze(uint8_t const* data, uint32_t linesize, uint64_t ts);
+    void Reset();
+    void Sample(gs_texture_t* tex);
+
+public:
+    FeedMonitor() = default;
+    ~FeedMonitor();
+
+    /// Any thread
+    void SetEnabled(bool enabled) { m_enabled = enabled; }
+    bool Enabled() const { return m_enabled; }
+
+    void AccountResources(ResourceUsage& usage) const
+    {
+        m_ring.AccountResources(usage);
+        m_textures.Account(usage);
+    }
+    Alarm GetAlarm() const { return m_alarm; }
+
+    /// Any thread, forgets the history, e.g. because the cell shows a different source now
+    void Restart() { m_restart = true; }
+
+    /// Graphics thread. Returns true while monitoring, in that case the source has to be
+    /// drawn at cx x cy between BeginCell() and EndCell() on every frame. It ends up in a
+    /// cell_cx x cell_cy texture with premultiplied alpha, which EndCell() returns for the
+    /// cell to draw with DrawCell(). EndCell() also stages a sample when one is due
+    bool BeginCell(uint32_t cx, uint32_t cy, uint32_t cell_cx, uint32_t cell_cy);
+    gs_texture_t* EndCell();
+    static void DrawCell(gs_texture_t* tex, uint32_t cx, uint32_t cy);
+
+    /// Graphics thread, once per render of the feed. Analyzes samples that finished copying
+    void Poll();
+};
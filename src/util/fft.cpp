@@ -0,0 +1,153 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "fft.hpp"
+#include <cmath>
+#include <graphics/math-defs.h>
+#include <util/sse-intrin.h>
+
+Fft::Fft(uint32_t size)
+    : m_size(size)
+    , m_half(size / 2)
+{
+    int bits = 0;
+    while ((1u << bits) < m_half)
+        bits++;
+
+    m_bitrev.resize(m_half);
+    for (uint32_t i = 0; i < m_half; i++) {
+        uint32_t r = 0;
+        for (int b = 0; b < bits; b++)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        m_bitrev[i] = r;
+    }
+
+    // Twiddles of every stage stored back to back, so a stage reads them with plain vector loads
+    m_twiddle_re.resize(m_half);
+    m_twiddle_im.resize(m_half);
+    for (uint32_t h = 1; h < m_half; h *= 2) {
+        for (uint32_t j = 0; j < h; j++) {
+            double a = -M_PI * j / h;
+            m_twiddle_re[h + j] = float(cos(a));
+            m_twiddle_im[h + j] = float(sin(a));
+        }
+    }
+
+    m_post_re.resize(m_half);
+    m_post_im.resize(m_half);
+    for (uint32_t k = 0; k < m_half; k++) {
+        double a = -2.0 * M_PI * k / m_size;
+        m_post_re[k] = float(cos(a));
+        m_post_im[k] = float(sin(a));
+    }
+
+    m_re.resize(m_half);
+    m_im.resize(m_half);
+}
+
+void Fft::Transform()
+{
+    float* re = m_re.data();
+    float* im = m_im.data();
+    const uint32_t n = m_half;
+
+    // The first two stages have spans below the vector width
+    for (uint32_t i = 0; i < n; i += 2) {
+        float ar = re[i], ai = im[i], br = re[i + 1], bi = im[i + 1];
+        re[i] = ar + br;
+        im[i] = ai + bi;
+        re[i + 1] = ar - br;
+        im[i + 1] = ai - bi;
+    }
+    for (uint32_t i = 0; i < n; i += 4) {
+        // Twiddles of span two are 1 and -i
+        float ar = re[i], ai = im[i], br = re[i + 2], bi = im[i + 2];
+        re[i] = ar + br;
+        im[i] = ai + bi;
+        re[i + 2] = ar - br;
+        im[i + 2] = ai - bi;
+        ar = re[i + 1];
+        ai = im[i + 1];
+        br = im[i + 3];
+        bi = -re[i + 3];
+        re[i + 1] = ar + br;
+        im[i + 1] = ai + bi;
+        re[i + 3] = ar - br;
+        im[i + 3] = ai - bi;
+    }
+
+    for (uint32_t h = 4; h < n; h *= 2) {
+        for (uint32_t start = 0; start < n; start += 2 * h) {
+            float* ar = re + start;
+            float* ai = im + start;
+            float* br = ar + h;
+            float* bi = ai + h;
+            for (uint32_t j = 0; j < h; j += 4) {
+                const __m128 wr = _mm_loadu_ps(&m_twiddle_re[h + j]);
+                const __m128 wi = _mm_loadu_ps(&m_twiddle_im[h + j]);
+                const __m128 xr = _mm_loadu_ps(br + j);
+                const __m128 xi = _mm_loadu_ps(bi + j);
+                const __m128 tr = _mm_sub_ps(_mm_mul_ps(xr, wr), _mm_mul_ps(xi, wi));
+                const __m128 ti = _mm_add_ps(_mm_mul_ps(xr, wi), _mm_mul_ps(xi, wr));
+                const __m128 yr = _mm_loadu_ps(ar + j);
+                const __m128 yi = _mm_loadu_ps(ai + j);
+                _mm_storeu_ps(ar + j, _mm_add_ps(yr, tr));
+                _mm_storeu_ps(ai + j, _mm_add_ps(yi, ti));
+                _mm_storeu_ps(br + j, _mm_sub_ps(yr, tr));
+                _mm_storeu_ps(bi + j, _mm_sub_ps(yi, ti));
+            }
+        }
+    }
+}
+
+void Fft::Power(float const* input, float const* window, float* power)
+{
+    // Even samples go into the real part, odd ones into the imaginary part
+    for (uint32_t i = 0; i < m_half; i++) {
+        uint32_t r = m_bitrev[i];
+        m_re[r] = input[2 * i] * window[2 * i];
+        m_im[r] = input[2 * i + 1] * window[2 * i + 1];
+    }
+
+    Transform();
+
+    // X[k] = E[k] + W^k * O[k], with E and O recovered from the packed transform Z
+    power[0] = (m_re[0] + m_im[0]) * (m_re[0] + m_im[0]);
+    power[m_half] = (m_re[0] - m_im[0]) * (m_re[0] - m_im[0]);
+    for (uint32_t k = 1; k < m_half; k++) {
+        const float zr = m_re[k], zi = m_im[k];
+        const float cr = m_re[m_half - k], ci = -m_im[m_half - k];
+        const float er = (zr + cr) * .5f, ei = (zi + ci) * .5f;
+        const float or_ = (zi - ci) * .5f, oi = (cr - zr) * .5f;
+        const float xr = er + m_post_re[k] * or_ - m_post_im[k] * oi;
+        const float xi = ei + m_post_re[k] * oi + m_post_im[k] * or_;
+        power[k] = xr * xr + xi * xi;
+    }
+}
+
+void Fft::ReferencePower(float const* input, float const* window, uint32_t size, float* power)
+{
+    for (uint32_t k = 0; k <= size / 2; k++) {
+        double re = 0, im = 0;
+        for (uint32_t i = 0; i < size; i++) {
+            double a = -2.0 * M_PI * double(uint64_t(k) * i % size) / size;
+            re += input[i] * window[i] * cos(a);
+            im += input[i] * window[i] * sin(a);
+        }
+        power[k] = float(re * re + im * im);
+    }
+}
@@ -0,0 +1,47 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Real FFT of a fixed power of two size. The input is packed into a complex
+// transform of half the size, which runs as iterative radix-2 stages over
+// split real/imaginary arrays so four butterflies share one SSE vector.
+// Everything is allocated by the constructor, transforms don't allocate.
+class Fft {
+    uint32_t m_size {}, m_half {};
+    std::vector<uint32_t> m_bitrev;
+    std::vector<float> m_twiddle_re, m_twiddle_im; // Stage twiddles, stage with span h starts at index h
+    std::vector<float> m_post_re, m_post_im;       // Twiddles to split the packed transform into the real spectrum
+    std::vector<float> m_re, m_im;
+
+    void Transform();
+
+public:
+    /// size has to be a power of two and at least 16
+    explicit Fft(uint32_t size);
+
+    uint32_t Size() const { return m_size; }
+    uint32_t Bins() const { return m_half + 1; }
+
+    /// Multiplies Size() samples with the window and writes the squared magnitude of Bins() bins
+    void Power(float const* input, float const* window, float* power);
+
+    /// O(n^2) reference for checking the fast path, see tools/fft_bench.cpp
+    static void ReferencePower(float const* input, float const* window, uint32_t size, float* power);
+};
@@ -0,0 +1,192 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "frame_stats.hpp"
+#include "util.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+#include <obs-module.h>
+#include <util/util.hpp>
+
+static inline int Magnitude(uint64_t value)
+{
+    int m = 0;
+    while (value >>= 1)
+        m++;
+    return m;
+}
+
+int LogHistogram::Index(uint64_t value)
+{
+    if (value < SUB_BUCKETS)
+        return int(value);
+    value = std::min(value, (uint64_t(1) << MAX_MAGNITUDE) - 1);
+    int m = Magnitude(value);
+    return (m - SUB_BITS + 1) * SUB_BUCKETS + int((value >> (m - SUB_BITS)) - SUB_BUCKETS);
+}
+
+uint64_t LogHistogram::LowerBound(int index)
+{
+    if (index < SUB_BUCKETS)
+        return uint64_t(index);
+    int m = index / SUB_BUCKETS + SUB_BITS - 1;
+    return uint64_t(SUB_BUCKETS + index % SUB_BUCKETS) << (m - SUB_BITS);
+}
+
+uint64_t LogHistogram::UpperBound(int index)
+{
+    if (index < SUB_BUCKETS)
+        return uint64_t(index);
+    int m = index / SUB_BUCKETS + SUB_BITS - 1;
+    return LowerBound(index) + (uint64_t(1) << (m - SUB_BITS)) - 1;
+}
+
+void LogHistogram::Record(uint64_t value)
+{
+    // Only one thread writes, so plain stores are enough and no locked instruction is needed
+    auto& bucket = m_counts[Index(value)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    m_sum.store(m_sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    if (value < m_min.load(std::memory_order_relaxed))
+        m_min.store(value, std::memory_order_relaxed);
+    if (value > m_max.load(std::memory_order_relaxed))
+        m_max.store(value, std::memory_order_relaxed);
+}
+
+LogHistogram::Snapshot LogHistogram::Read() const
+{
+    Snapshot s;
+    s.counts.resize(BUCKETS);
+    for (int i = 0; i < BUCKETS; i++) {
+        s.counts[i] = m_counts[i].load(std::memory_order_relaxed);
+        s.count += s.counts[i];
+    }
+    s.sum = m_sum.load(std::memory_order_relaxed);
+    s.min = s.count ? m_min.load(std::memory_order_relaxed) : 0;
+    s.max = m_max.load(std::memory_order_relaxed);
+    return s;
+}
+
+uint64_t LogHistogram::Snapshot::Percentile(double p) const
+{
+    if (count == 0)
+        return 0;
+    auto target = std::max<uint64_t>(1, uint64_t(std::ceil(p / 100.0 * count)));
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= target)
+            return std::min(UpperBound(i), max);
+    }
+    return max;
+}
+
+void FrameStats::Record(uint64_t start, uint64_t end, uint32_t items)
+{
+    m_render.Record(end - start);
+    if (m_last_frame)
+        m_interval.Record(start - m_last_frame);
+    m_items.Record(items);
+    m_last_frame = start;
+}
+
+static const double percentiles[] = { 50, 90, 95, 99, 99.9 };
+
+// Durations are stored in ns but exported in µs, which reads better for frame times
+static QJsonObject ToJson(LogHistogram::Snapshot const& s, double unit)
+{
+    QJsonObject obj;
+    obj["count"] = double(s.count);
+    obj["mean"] = s.Mean() / unit;
+    obj["min"] = s.min / unit;
+    obj["max"] = s.max / unit;
+
+    QJsonObject p;
+    for (double pct : percentiles)
+        p[QString("p%1").arg(pct)] = s.Percentile(pct) / unit;
+    obj["percentiles"] = p;
+
+    QJsonArray buckets;
+    for (int i = 0; i < LogHistogram::BUCKETS; i++) {
+        if (s.counts[i] == 0)
+            continue;
+        buckets.append(QJsonArray { LogHistogram::LowerBound(i) / unit, LogHistogram::UpperBound(i) / unit, double(s.counts[i]) });
+    }
+    obj["buckets"] = buckets;
+    return obj;
+}
+
+static void ToCsv(QTextStream& csv, char const* name, LogHistogram::Snapshot const& s, double unit)
+{
+    uint64_t seen = 0;
+    for (int i = 0; i < LogHistogram::BUCKETS; i++) {
+        if (s.counts[i] == 0)
+            continue;
+        seen += s.counts[i];
+        csv << name << ',' << LogHistogram::LowerBound(i) / unit << ',' << LogHistogram::UpperBound(i) / unit << ','
+            << s.counts[i] << ',' << 100.0 * seen / s.count << '\n';
+    }
+}
+
+QString FrameStats::Export(QString const& name) const
+{
+    BPtr<char> path = obs_module_config_path("frame_stats");
+    QDir dir(utf8_to_qt(path.Get()));
+    if (!dir.mkpath(".")) {
+        bwarn("Couldn't create frame statistics directory '%s'", path.Get());
+        return {};
+    }
+
+    auto now = QDateTime::currentDateTime();
+    auto base = dir.filePath(QString("%1_%2").arg(name.isEmpty() ? "multiview" : name, now.toString("yyyy-MM-dd_HH-mm-ss")));
+    auto render = m_render.Read();
+    auto interval = m_interval.Read();
+    auto items = m_items.Read();
+
+    QJsonObject root;
+    root["multiview"] = name;
+    root["time"] = now.toString(Qt::ISODate);
+    root["render_us"] = ToJson(render, 1000.0);
+    root["interval_us"] = ToJson(interval, 1000.0);
+    root["items"] = ToJson(items, 1.0);
+
+    QFile json(base + ".json");
+    if (!json.open(QIODevice::WriteOnly) || json.write(QJsonDocument(root).toJson()) < 0) {
+        bwarn("Couldn't write frame statistics to '%s'", qt_to_utf8(json.fileName()));
+        return {};
+    }
+
+    QFile file(base + ".csv");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        bwarn("Couldn't write frame statistics to '%s'", qt_to_utf8(file.fileName()));
+        return {};
+    }
+    QTextStream csv(&file);
+    csv << "histogram,lower,upper,count,cumulative_percent\n";
+    ToCsv(csv, "render_us", render, 1000.0);
+    ToCsv(csv, "interval_us", interval, 1000.0);
+    ToCsv(csv, "items", items, 1.0);
+
+    return json.fileName();
+}
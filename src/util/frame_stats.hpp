@@ -0,0 +1,78 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#pragma once
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Log-linear histogram in the style of HdrHistogram: values below 2^SUB_BITS
+// get a bucket each, every power of two above that is split into SUB_BUCKETS
+// buckets, so the relative error stays below 1 / SUB_BUCKETS across the range.
+// The bucket array is fixed, a single thread records and any thread can read.
+class LogHistogram {
+public:
+    static constexpr int SUB_BITS = 5;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+    static constexpr int MAX_MAGNITUDE = 40; // Values from 2^40 on land in the last bucket
+    static constexpr int BUCKETS = (MAX_MAGNITUDE - SUB_BITS + 1) * SUB_BUCKETS;
+
+    struct Snapshot {
+        std::vector<uint64_t> counts;
+        uint64_t count {}, sum {}, min {}, max {};
+
+        double Mean() const { return count ? double(sum) / count : 0; }
+        /// Upper bound of the bucket the given percentile (0-100) falls into
+        uint64_t Percentile(double p) const;
+    };
+
+private:
+    std::atomic<uint64_t> m_counts[BUCKETS] {};
+    std::atomic<uint64_t> m_sum {}, m_min { UINT64_MAX }, m_max {};
+
+public:
+    static int Index(uint64_t value);
+    static uint64_t LowerBound(int index);
+    static uint64_t UpperBound(int index); // Inclusive
+
+    /// Recording thread only, never blocks
+    void Record(uint64_t value);
+
+    /// Any thread. Buckets are read one by one, a concurrent Record() shows up in either the count or not at all
+    Snapshot Read() const;
+};
+
+// Frame timing of one multiview window: how long the render callback took,
+// the time between two callbacks and how many items were drawn per frame.
+class FrameStats {
+    LogHistogram m_render;   // ns
+    LogHistogram m_interval; // ns
+    LogHistogram m_items;
+    uint64_t m_last_frame {}; // Graphics thread only, 0 after a pause
+
+public:
+    /// Graphics thread, once per rendered frame
+    void Record(uint64_t start, uint64_t end, uint32_t items);
+
+    /// Graphics thread, the window skipped rendering so the next interval isn't meaningful
+    void Pause() { m_last_frame = 0; }
+
+    /// UI thread. Writes <name>_<time>.json and .csv to the frame_stats folder in the plugin config
+    /// directory, returns the path of the JSON file or an empty string on failure
+    QString Export(QString const& name) const;
+};
@@ -0,0 +1,103 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "goniometer.hpp"
+#include <cmath>
+#include <cstring>
+#include <util/sse-intrin.h>
+
+// Averaging time of the correlation in seconds, close to what hardware meters use
+#define CORRELATION_TIME 0.3
+// Below this mean square level (about -70 dBFS) the correlation reads 0
+#define SILENCE 1e-7
+
+void Goniometer::Reset(uint32_t channels, uint32_t sample_rate, speaker_layout)
+{
+    m_channels = channels;
+    m_sample_rate = sample_rate ? sample_rate : 48000;
+    m_lr = m_ll = m_rr = 0;
+    m_ring_pos = 0;
+    memset(m_ring_x, 0, sizeof(m_ring_x));
+    memset(m_ring_y, 0, sizeof(m_ring_y));
+    m_correlation = 0.f;
+
+    memset(&m_points.Back(), 0, sizeof(Points));
+    m_points.Publish();
+}
+
+void Goniometer::Process(float const* samples, uint32_t frames)
+{
+    if (!m_channels || !frames)
+        return;
+
+    const uint32_t stride = m_channels;
+    const uint32_t right = m_channels > 1 ? 1 : 0; // Mono shows up as a vertical line
+    const __m128 half = _mm_set1_ps(.5f);
+    __m128 lr = _mm_setzero_ps(), ll = _mm_setzero_ps(), rr = _mm_setzero_ps();
+
+    uint32_t f = 0;
+    for (; f + 4 <= frames; f += 4) {
+        float const* s = samples + size_t(f) * stride;
+        __m128 l, r;
+        if (stride == 2) {
+            const __m128 a = _mm_loadu_ps(s), b = _mm_loadu_ps(s + 4);
+            l = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        } else {
+            l = _mm_setr_ps(s[0], s[stride], s[2 * stride], s[3 * stride]);
+            r = _mm_setr_ps(s[right], s[stride + right], s[2 * stride + right], s[3 * stride + right]);
+        }
+        lr = _mm_add_ps(lr, _mm_mul_ps(l, r));
+        ll = _mm_add_ps(ll, _mm_mul_ps(l, l));
+        rr = _mm_add_ps(rr, _mm_mul_ps(r, r));
+
+        const __m128 side = _mm_mul_ps(_mm_sub_ps(r, l), half);
+        const __m128 mid = _mm_mul_ps(_mm_add_ps(l, r), half);
+        m_ring_x[m_ring_pos] = _mm_cvtss_f32(side);
+        m_ring_y[m_ring_pos] = _mm_cvtss_f32(mid);
+        m_ring_pos = (m_ring_pos + 1) % POINTS;
+    }
+
+    alignas(16) float sums[3][4];
+    _mm_store_ps(sums[0], lr);
+    _mm_store_ps(sums[1], ll);
+    _mm_store_ps(sums[2], rr);
+    double sum_lr = sums[0][0] + sums[0][1] + sums[0][2] + sums[0][3];
+    double sum_ll = sums[1][0] + sums[1][1] + sums[1][2] + sums[1][3];
+    double sum_rr = sums[2][0] + sums[2][1] + sums[2][2] + sums[2][3];
+    for (; f < frames; f++) {
+        float const* s = samples + size_t(f) * stride;
+        sum_lr += s[0] * s[right];
+        sum_ll += s[0] * s[0];
+        sum_rr += s[right] * s[right];
+    }
+
+    // One exponential step for the whole block, weighted by its length
+    const double keep = exp(-double(frames) / (CORRELATION_TIME * m_sample_rate));
+    m_lr = m_lr * keep + (1 - keep) * sum_lr / frames;
+    m_ll = m_ll * keep + (1 - keep) * sum_ll / frames;
+    m_rr = m_rr * keep + (1 - keep) * sum_rr / frames;
+    m_correlation = m_ll > SILENCE && m_rr > SILENCE ? float(m_lr / sqrt(m_ll * m_rr)) : 0.f;
+
+    auto& out = m_points.Back();
+    const uint32_t tail = POINTS - m_ring_pos;
+    memcpy(out.x, m_ring_x + m_ring_pos, tail * sizeof(float));
+    memcpy(out.x + tail, m_ring_x, m_ring_pos * sizeof(float));
+    memcpy(out.y, m_ring_y + m_ring_pos, tail * sizeof(float));
+    memcpy(out.y + tail, m_ring_y, m_ring_pos * sizeof(float));
+    m_points.Publish();
+}
@@ -0,0 +1,55 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#pragma once
+#include "audio_tap.hpp"
+#include "triple_buffer.hpp"
+#include <atomic>
+
+// Phase correlation and a decimated Lissajous figure of the first two
+// channels, computed on the worker of an AudioTap. Four frames are processed
+// per SSE vector: the correlation sums use all of them, the point cloud keeps
+// the first frame of every vector.
+class Goniometer : public AudioConsumer {
+public:
+    static constexpr uint32_t POINTS = 2048;
+
+    // Side on x, mid on y, both within [-1, 1] for signals within full scale
+    struct Points {
+        float x[POINTS];
+        float y[POINTS];
+    };
+
+private:
+    uint32_t m_channels {}, m_sample_rate {};
+    double m_lr {}, m_ll {}, m_rr {}; // Exponentially averaged products
+    float m_ring_x[POINTS] {}, m_ring_y[POINTS] {};
+    uint32_t m_ring_pos {};
+
+    std::atomic<float> m_correlation { 0.f };
+    TripleBuffer<Points> m_points;
+
+public:
+    void Reset(uint32_t channels, uint32_t sample_rate, speaker_layout speakers) override;
+    void Process(float const* samples, uint32_t frames) override;
+
+    /// Any thread, +1 for mono, 0 for unrelated and -1 for inverted channels. 0 while silent
+    float Correlation() const { return m_correlation; }
+
+    /// Render thread only
+    Points const& Read() { return m_points.Front(); }
+};
@@ -0,0 +1,267 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "label_atlas.hpp"
+#include "util.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <graphics/vec2.h>
+
+#define VERTICES_PER_LABEL 6
+#define MIN_COLUMNS 8
+
+uint64_t LabelAtlas::NextId()
+{
+    static std::atomic<uint64_t> next_id { 1 };
+    return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+LabelAtlas::~LabelAtlas()
+{
+    if (m_texrender || m_vertices) {
+        obs_enter_graphics();
+        gs_texrender_destroy(m_texrender);
+        gs_vertexbuffer_destroy(m_vertices);
+        obs_leave_graphics();
+    }
+}
+
+void LabelAtlas::Begin()
+{
+    m_requests.clear();
+    m_quads.clear();
+}
+
+void LabelAtlas::Add(uint64_t id, OBSSource label, float scale, float x, float y)
+{
+    if (label && scale > 0)
+        m_requests.emplace_back(Request { id, std::move(label), scale, x, y });
+}
+
+bool LabelAtlas::Grow(int columns, int column_width, int height)
+{
+    // Every label has to be rasterized again after this, the texture is recreated at its new size
+    gs_texrender_destroy(m_texrender);
+    m_texrender = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+    m_slots.clear();
+    m_free_columns.clear();
+    m_columns = columns;
+    m_column_width = column_width;
+    m_height = height;
+    for (int i = columns; i > 0; i--)
+        m_free_columns.emplace_back(i - 1);
+
+    gs_texrender_reset(m_texrender);
+    if (!gs_texrender_begin(m_texrender, m_columns * m_column_width, m_height)) {
+        berr("Failed to create %ix%i label atlas", m_columns * m_column_width, m_height);
+        return false;
+    }
+    m_textures.Resize(m_texture_cx, m_texture_cy, m_columns * m_column_width, m_height, 4);
+    vec4 clear_color;
+    vec4_zero(&clear_color);
+    gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
+    gs_texrender_end(m_texrender);
+    return true;
+}
+
+bool LabelAtlas::EnsureVertexCapacity(uint32_t quads)
+{
+    if (quads <= m_vertex_capacity && m_vertices)
+        return true;
+
+    uint32_t capacity = std::max(m_vertex_capacity, 16u);
+    while (capacity < quads)
+        capacity *= 2;
+
+    gs_vertexbuffer_destroy(m_vertices);
+    m_vertex_capacity = 0;
+
+    auto* vbd = gs_vbdata_create();
+    vbd->num = capacity * VERTICES_PER_LABEL;
+    vbd->points = (vec3*)bzalloc(sizeof(vec3) * vbd->num);
+    vbd->num_tex = 1;
+    vbd->tvarray = (gs_tvertarray*)bzalloc(sizeof(gs_tvertarray));
+    vbd->tvarray[0].width = 2;
+    vbd->tvarray[0].array = bzalloc(sizeof(vec2) * vbd->num);
+    m_vertices = gs_vertexbuffer_create(vbd, GS_DYNAMIC);
+
+    if (!m_vertices) {
+        berr("Failed to create label vertex buffer for %u labels", capacity);
+        return false;
+    }
+    m_vertex_capacity = capacity;
+    return true;
+}
+
+void LabelAtlas::Rasterize(std::vector<std::pair<Request const*, Slot const*>> const& dirty)
+{
+    gs_texrender_reset(m_texrender);
+    if (!gs_texrender_begin(m_texrender, m_columns * m_column_width, m_height))
+        return;
+
+    gs_ortho(0.0f, float(m_columns * m_column_width), 0.0f, float(m_height), -100.0f, 100.0f);
+
+    // Columns are overwritten as they are, the atlas keeps the straight alpha of the text
+    gs_blend_state_push();
+    gs_enable_blending(false);
+
+    gs_effect_t* solid = obs_get_base_effect(OBS_EFFECT_SOLID);
+    gs_eparam_t* color = gs_effect_get_param_by_name(solid, "color");
+    vec4 transparent;
+    vec4_zero(&transparent);
+
+    for (auto const& [request, slot] : dirty) {
+        const float left = float(slot->column * m_column_width);
+
+        // Columns are reused, clear whatever label was there before
+        gs_matrix_push();
+        gs_matrix_translate3f(left, 0.0f, 0.0f);
+        gs_effect_set_vec4(color, &transparent);
+        while (gs_effect_loop(solid, "Solid"))
+            gs_draw_sprite(nullptr, 0, m_column_width, m_height);
+        gs_matrix_pop();
+
+        gs_matrix_push();
+        gs_matrix_translate3f(left + slot->cx, 0.0f, 0.0f);
+        gs_matrix_rotaa4f(0, 0, 1, RAD(90));
+        obs_source_video_render(request->label);
+        gs_matrix_pop();
+    }
+
+    gs_blend_state_pop();
+    gs_texrender_end(m_texrender);
+}
+
+void LabelAtlas::Draw()
+{
+    // Labels that weren't queued this frame belong to sliders that were removed,
+    // scrolled out of view or renamed
+    std::unordered_set<uint64_t> requested;
+    for (auto const& r : m_requests)
+        requested.insert(r.id);
+    for (auto it = m_slots.begin(); it != m_slots.end();) {
+        if (!requested.count(it->first)) {
+            m_free_columns.emplace_back(it->second.column);
+            it = m_slots.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (m_requests.empty())
+        return;
+
+    // Check whether the new labels still fit, otherwise start over with a bigger atlas
+    int column_width = m_column_width, height = m_height, new_labels = 0;
+    for (auto const& r : m_requests) {
+        auto it = m_slots.find(r.id);
+        int cx = int(obs_source_get_height(r.label));
+        int cy = int(obs_source_get_width(r.label));
+        if (it == m_slots.end() && cx > 0 && cy > 0) {
+            // One texel of padding so filtering doesn't pick up the neighbouring column
+            new_labels++;
+            column_width = std::max(column_width, cx + 1);
+            height = std::max(height, cy + 1);
+        }
+    }
+
+    if (column_width <= 0 || height <= 0)
+        return;
+    if (!m_texrender || column_width > m_column_width || height > m_height || new_labels > int(m_free_columns.size())) {
+        int columns = std::max(m_columns, MIN_COLUMNS);
+        while (columns < int(m_requests.size()))
+            columns *= 2;
+        if (!Grow(columns, column_width, height))
+            return;
+    }
+
+    std::vector<std::pair<Request const*, Slot const*>> dirty;
+    for (auto const& r : m_requests) {
+        if (m_slots.count(r.id))
+            continue;
+        int cx = int(obs_source_get_height(r.label));
+        int cy = int(obs_source_get_width(r.label));
+        // Text sources can report no size until their first update went through, try again next frame
+        if (cx <= 0 || cy <= 0 || m_free_columns.empty())
+            continue;
+
+        Slot slot { m_free_columns.back(), float(cx), float(cy) };
+        m_free_columns.pop_back();
+        auto inserted = m_slots.emplace(r.id, slot);
+        dirty.emplace_back(&r, &inserted.first->second);
+    }
+    if (!dirty.empty())
+        Rasterize(dirty);
+
+    const float atlas_cx = float(m_columns * m_column_width);
+    const float atlas_cy = float(m_height);
+    for (auto const& r : m_requests) {
+        auto it = m_slots.find(r.id);
+        if (it == m_slots.end())
+            continue;
+        auto const& slot = it->second;
+        const float left = float(slot.column * m_column_width);
+
+        Quad q;
+        q.left = r.x - slot.cx / r.scale;
+        q.top = r.y;
+        q.right = r.x;
+        q.bottom = r.y + slot.cy / r.scale;
+        q.u0 = left / atlas_cx;
+        q.v0 = 0.0f;
+        q.u1 = (left + slot.cx) / atlas_cx;
+        q.v1 = slot.cy / atlas_cy;
+        m_quads.emplace_back(q);
+    }
+
+    auto count = uint32_t(m_quads.size());
+    if (count == 0 || !EnsureVertexCapacity(count))
+        return;
+
+    auto* vbd = gs_vertexbuffer_get_data(m_vertices);
+    auto* uv = static_cast<vec2*>(vbd->tvarray[0].array);
+    for (uint32_t i = 0; i < count; i++) {
+        auto const& q = m_quads[i];
+        auto* p = vbd->points + i * VERTICES_PER_LABEL;
+        auto* t = uv + i * VERTICES_PER_LABEL;
+
+        vec3_set(&p[0], q.left, q.top, 0);
+        vec3_set(&p[1], q.right, q.top, 0);
+        vec3_set(&p[2], q.left, q.bottom, 0);
+        vec3_set(&p[3], q.left, q.bottom, 0);
+        vec3_set(&p[4], q.right, q.top, 0);
+        vec3_set(&p[5], q.right, q.bottom, 0);
+        vec2_set(&t[0], q.u0, q.v0);
+        vec2_set(&t[1], q.u1, q.v0);
+        vec2_set(&t[2], q.u0, q.v1);
+        vec2_set(&t[3], q.u0, q.v1);
+        vec2_set(&t[4], q.u1, q.v0);
+        vec2_set(&t[5], q.u1, q.v1);
+    }
+    gs_vertexbuffer_flush(m_vertices);
+
+    gs_effect_t* effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+    gs_eparam_t* image = gs_effect_get_param_by_name(effect, "image");
+    gs_effect_set_texture(image, gs_texrender_get_texture(m_texrender));
+
+    gs_load_vertexbuffer(m_vertices);
+    gs_load_indexbuffer(nullptr);
+    while (gs_effect_loop(effect, "Draw"))
+        gs_draw(GS_TRIS, 0, count * VERTICES_PER_LABEL);
+    gs_load_vertexbuffer(nullptr);
+}
@@ -0,0 +1,86 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#pragma once
+#include "resource_usage.hpp"
+#include <cstdint>
+#include <obs.hpp>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Caches rotated text labels in one texture, one column per label, so
+// they can be drawn with a single draw call. Labels are identified by an id
+// that changes whenever their text or font changes, a label is only
+// rasterized again when its id is new or the atlas had to grow.
+// Render thread only.
+class LabelAtlas {
+    struct Slot {
+        int column;
+        float cx, cy; // Size of the rotated label in texels
+    };
+
+    struct Request {
+        uint64_t id;
+        OBSSource label;
+        float scale;
+        float x, y;
+    };
+
+    struct Quad {
+        float left, top, right, bottom;
+        float u0, v0, u1, v1;
+    };
+
+    gs_texrender_t* m_texrender {};
+    gs_vertbuffer_t* m_vertices {};
+    uint32_t m_vertex_capacity {};
+
+    std::unordered_map<uint64_t, Slot> m_slots;
+    std::vector<int> m_free_columns;
+    int m_columns {}, m_column_width {}, m_height {};
+    uint32_t m_texture_cx {}, m_texture_cy {};
+    TextureTally m_textures;
+
+    std::vector<Request> m_requests;
+    std::vector<Quad> m_quads;
+
+    bool Grow(int columns, int column_width, int height);
+    bool EnsureVertexCapacity(uint32_t quads);
+    void Rasterize(std::vector<std::pair<Request const*, Slot const*>> const& dirty);
+
+public:
+    LabelAtlas() = default;
+    ~LabelAtlas();
+
+    /// Returns a new id for a label whose text or font changed, can be called from any thread
+    static uint64_t NextId();
+
+    /// Discards the labels of the previous frame
+    void Begin();
+
+    /// Queues the label source rotated by 90 degrees with its top right corner at x/y
+    /// (current matrix). scale is the factor the label's font was scaled by
+    void Add(uint64_t id, OBSSource label, float scale, float x, float y);
+
+    /// Rasterizes new labels, frees the columns of labels that weren't added
+    /// this frame and draws all queued labels with one draw call
+    void Draw();
+
+    /// Any thread
+    void AccountResources(ResourceUsage& usage) const { m_textures.Account(usage); }
+};
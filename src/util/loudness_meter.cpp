@@ -0,0 +1,294 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "loudness_meter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <graphics/math-defs.h>
+#include <util/sse-intrin.h>
+
+#define ABSOLUTE_GATE -70.0
+#define RELATIVE_GATE -10.0
+#define BIN_WIDTH 0.1
+#define SURROUND_WEIGHT 1.41f
+
+static inline double Loudness(double power)
+{
+    return -0.691 + 10.0 * log10(power);
+}
+
+static inline __m128 LoadLanes(float const* frame, int lanes)
+{
+    switch (lanes) {
+    case 1:
+        return _mm_load_ss(frame);
+    case 2:
+        return _mm_setr_ps(frame[0], frame[1], 0.f, 0.f);
+    case 3:
+        return _mm_setr_ps(frame[0], frame[1], frame[2], 0.f);
+    default:
+        return _mm_loadu_ps(frame);
+    }
+}
+
+// BS.1770 gives surround channels more weight and ignores the LFE, channel order is the one of libobs
+static float ChannelWeight(speaker_layout speakers, uint32_t channel)
+{
+    switch (speakers) {
+    case SPEAKERS_2POINT1:
+        return channel == 2 ? 0.f : 1.f;
+    case SPEAKERS_4POINT0:
+        return channel == 3 ? SURROUND_WEIGHT : 1.f;
+    case SPEAKERS_4POINT1:
+        return channel == 3 ? 0.f : (channel == 4 ? SURROUND_WEIGHT : 1.f);
+    case SPEAKERS_5POINT1:
+    case SPEAKERS_7POINT1:
+        return channel == 3 ? 0.f : (channel >= 4 ? SURROUND_WEIGHT : 1.f);
+    default:
+        return 1.f;
+    }
+}
+
+LoudnessMeter::LoudnessMeter()
+    : m_momentary(-INFINITY)
+    , m_short_term(-INFINITY)
+    , m_integrated(-INFINITY)
+    , m_true_peak(-INFINITY)
+{
+    m_histogram.resize(HISTOGRAM_BINS);
+    m_bin_power.resize(HISTOGRAM_BINS);
+
+    // 4x polyphase interpolator: Blackman windowed sinc, phase p sits p / 4 samples after the middle of the window
+    for (int p = 0; p < TP_PHASES; p++) {
+        double coef[TP_TAPS], sum = 0;
+        for (int k = 0; k < TP_TAPS; k++) {
+            double t = k - (TP_TAPS / 2 - 1) - double(p) / TP_PHASES;
+            double sinc = t == 0 ? 1.0 : sin(M_PI * t) / (M_PI * t);
+            double w = 0.42 + 0.5 * cos(M_PI * t / (TP_TAPS / 2)) + 0.08 * cos(2 * M_PI * t / (TP_TAPS / 2));
+            coef[k] = sinc * w;
+            sum += coef[k];
+        }
+        for (int k = 0; k < TP_TAPS; k++)
+            m_tp_coef[p][k] = float(coef[k] / sum);
+    }
+}
+
+void LoudnessMeter::Reset(uint32_t channels, uint32_t sample_rate, speaker_layout speakers)
+{
+    // Decaying filter state would otherwise run into denormals during silence
+    _mm_setcsr(_mm_getcsr() | 0x8040);
+
+    m_channels = std::min<uint32_t>(channels, VECTORS * 4);
+    m_vectors = int((m_channels + 3) / 4);
+    m_block_frames = std::max<uint32_t>(sample_rate / 10, 1);
+    m_block_pos = 0;
+
+    // K-weighting, pre-filter and RLB high-pass as two biquads. The analog prototypes
+    // are matched to the sample rate, at 48 kHz this yields the coefficients of BS.1770
+    const double rate = sample_rate;
+    double f0 = 1681.974450955533, gain = 3.999843853973347, q = 0.7071752369554196;
+    double k = tan(M_PI * f0 / rate);
+    double vh = pow(10.0, gain / 20.0);
+    double vb = pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    m_shelf[0] = float((vh + vb * k / q + k * k) / a0);
+    m_shelf[1] = float(2.0 * (k * k - vh) / a0);
+    m_shelf[2] = float((vh - vb * k / q + k * k) / a0);
+    m_shelf[3] = float(2.0 * (k * k - 1.0) / a0);
+    m_shelf[4] = float((1.0 - k / q + k * k) / a0);
+
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = tan(M_PI * f0 / rate);
+    a0 = 1.0 + k / q + k * k;
+    m_highpass[0] = 1.f;
+    m_highpass[1] = -2.f;
+    m_highpass[2] = 1.f;
+    m_highpass[3] = float(2.0 * (k * k - 1.0) / a0);
+    m_highpass[4] = float((1.0 - k / q + k * k) / a0);
+
+    for (uint32_t c = 0; c < VECTORS * 4; c++)
+        m_weights[c] = c < m_channels ? ChannelWeight(speakers, c) : 0.f;
+
+    memset(m_state, 0, sizeof(m_state));
+    memset(m_blocks, 0, sizeof(m_blocks));
+    m_history_pos = 0;
+    m_block_count = 0;
+    m_reset_integrated = false;
+    ClearIntegrated();
+
+    m_momentary = -INFINITY;
+    m_short_term = -INFINITY;
+}
+
+void LoudnessMeter::ClearIntegrated()
+{
+    std::fill(m_histogram.begin(), m_histogram.end(), 0);
+    std::fill(m_bin_power.begin(), m_bin_power.end(), 0.0);
+    for (auto& s : m_state)
+        memset(s.peak, 0, sizeof(s.peak));
+    m_integrated = -INFINITY;
+    m_true_peak = -INFINITY;
+}
+
+void LoudnessMeter::ProcessVector(State& s, float const* samples, uint32_t frames, int first_channel)
+{
+    const int lanes = std::min<int>(4, int(m_channels) - first_channel);
+    const __m128 sb0 = _mm_set1_ps(m_shelf[0]), sb1 = _mm_set1_ps(m_shelf[1]), sb2 = _mm_set1_ps(m_shelf[2]);
+    const __m128 sa1 = _mm_set1_ps(m_shelf[3]), sa2 = _mm_set1_ps(m_shelf[4]);
+    const __m128 hb0 = _mm_set1_ps(m_highpass[0]), hb1 = _mm_set1_ps(m_highpass[1]), hb2 = _mm_set1_ps(m_highpass[2]);
+    const __m128 ha1 = _mm_set1_ps(m_highpass[3]), ha2 = _mm_set1_ps(m_highpass[4]);
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+    __m128 z1a = _mm_load_ps(s.z[0]), z2a = _mm_load_ps(s.z[1]);
+    __m128 z1b = _mm_load_ps(s.z[2]), z2b = _mm_load_ps(s.z[3]);
+    __m128 energy = _mm_load_ps(s.energy);
+    __m128 peak = _mm_load_ps(s.peak);
+    int pos = m_history_pos;
+
+    __m128 coef[TP_PHASES][TP_TAPS];
+    for (int p = 0; p < TP_PHASES; p++)
+        for (int k = 0; k < TP_TAPS; k++)
+            coef[p][k] = _mm_set1_ps(m_tp_coef[p][k]);
+
+    for (uint32_t f = 0; f < frames; f++) {
+        __m128 x = LoadLanes(samples + size_t(f) * m_channels + first_channel, lanes);
+
+        // True peak, each phase is a dot product over the last TP_TAPS input samples of all four channels
+        _mm_store_ps(s.history[pos], x);
+        _mm_store_ps(s.history[pos + TP_TAPS], x);
+        pos = pos + 1 == TP_TAPS ? 0 : pos + 1;
+        float const(*window)[4] = s.history + pos; // Oldest sample first
+        for (int p = 0; p < TP_PHASES; p++) {
+            __m128 acc = _mm_setzero_ps();
+            for (int k = 0; k < TP_TAPS; k++)
+                acc = _mm_add_ps(acc, _mm_mul_ps(coef[p][k], _mm_load_ps(window[k])));
+            peak = _mm_max_ps(peak, _mm_and_ps(acc, abs_mask));
+        }
+
+        // K-weighting
+        __m128 y = _mm_add_ps(_mm_mul_ps(sb0, x), z1a);
+        z1a = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(sb1, x), _mm_mul_ps(sa1, y)), z2a);
+        z2a = _mm_sub_ps(_mm_mul_ps(sb2, x), _mm_mul_ps(sa2, y));
+        x = y;
+        y = _mm_add_ps(_mm_mul_ps(hb0, x), z1b);
+        z1b = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(hb1, x), _mm_mul_ps(ha1, y)), z2b);
+        z2b = _mm_sub_ps(_mm_mul_ps(hb2, x), _mm_mul_ps(ha2, y));
+
+        energy = _mm_add_ps(energy, _mm_mul_ps(y, y));
+    }
+
+    _mm_store_ps(s.z[0], z1a);
+    _mm_store_ps(s.z[1], z2a);
+    _mm_store_ps(s.z[2], z1b);
+    _mm_store_ps(s.z[3], z2b);
+    _mm_store_ps(s.energy, energy);
+    _mm_store_ps(s.peak, peak);
+}
+
+void LoudnessMeter::Process(float const* samples, uint32_t frames)
+{
+    if (!m_channels)
+        return;
+    if (m_reset_integrated.exchange(false))
+        ClearIntegrated();
+
+    while (frames > 0) {
+        // Never cross a block boundary, so each block ends up with exactly its own samples
+        uint32_t chunk = std::min(frames, m_block_frames - m_block_pos);
+        for (int v = 0; v < m_vectors; v++)
+            ProcessVector(m_state[v], samples, chunk, v * 4);
+        m_history_pos = int((m_history_pos + chunk) % TP_TAPS);
+
+        samples += size_t(chunk) * m_channels;
+        frames -= chunk;
+        m_block_pos += chunk;
+        if (m_block_pos == m_block_frames) {
+            m_block_pos = 0;
+            FinishBlock();
+        }
+    }
+}
+
+void LoudnessMeter::FinishBlock()
+{
+    float power = 0, peak = 0;
+    for (int c = 0; c < m_vectors * 4; c++) {
+        auto& s = m_state[c / 4];
+        power += m_weights[c] * s.energy[c % 4];
+        peak = std::max(peak, s.peak[c % 4]);
+    }
+    for (auto& s : m_state)
+        memset(s.energy, 0, sizeof(s.energy));
+
+    m_blocks[m_block_count % SHORT_BLOCKS] = power / float(m_block_frames);
+    m_block_count++;
+
+    // Until a window is full the meter shows what it has got so far
+    auto mean = [this](uint64_t n) {
+        n = std::min<uint64_t>(n, m_block_count);
+        double sum = 0;
+        for (uint64_t i = 0; i < n; i++)
+            sum += m_blocks[(m_block_count - 1 - i) % SHORT_BLOCKS];
+        return sum / double(n);
+    };
+
+    double momentary = mean(MOMENTARY_BLOCKS);
+    m_momentary = float(Loudness(momentary));
+    m_short_term = float(Loudness(mean(SHORT_BLOCKS)));
+
+    // Gating blocks are the 400 ms windows with 75% overlap, which is exactly the momentary loudness
+    if (m_block_count >= MOMENTARY_BLOCKS) {
+        double l = Loudness(momentary);
+        if (l >= ABSOLUTE_GATE) {
+            int bin = std::min(int((l - ABSOLUTE_GATE) / BIN_WIDTH), HISTOGRAM_BINS - 1);
+            m_histogram[bin]++;
+            m_bin_power[bin] += momentary;
+        }
+    }
+    m_integrated = Integrated();
+    m_true_peak = peak > 0 ? 20.f * log10f(peak) : -INFINITY;
+}
+
+float LoudnessMeter::Integrated() const
+{
+    double count = 0, sum = 0;
+    for (int i = 0; i < HISTOGRAM_BINS; i++) {
+        count += m_histogram[i];
+        sum += m_bin_power[i];
+    }
+    if (count == 0)
+        return -INFINITY;
+
+    double gate = Loudness(sum / count) + RELATIVE_GATE;
+    count = 0;
+    sum = 0;
+    for (int i = 0; i < HISTOGRAM_BINS; i++) {
+        // Blocks are only known to the bin, a bin counts once its center passes the gate
+        if (ABSOLUTE_GATE + (i + 0.5) * BIN_WIDTH < gate)
+            continue;
+        count += m_histogram[i];
+        sum += m_bin_power[i];
+    }
+    return count > 0 ? float(Loudness(sum / count)) : -INFINITY;
+}
+
+LoudnessMeter::Readings LoudnessMeter::Read() const
+{
+    return { m_momentary, m_short_term, m_integrated, m_true_peak };
+}
@@ -0,0 +1,86 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#pragma once
+#include "audio_tap.hpp"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// EBU R128 / ITU-R BS.1770 loudness measurement. Runs on the worker of an
+// AudioTap: K-weighting and the true-peak oversampler process four channels
+// per SIMD vector, so stereo costs the same as quad. Readings are published
+// through atomics after every 100 ms block and can be read from any thread.
+class LoudnessMeter : public AudioConsumer {
+public:
+    struct Readings {
+        float momentary;  // LUFS, 400 ms window
+        float short_term; // LUFS, 3 s window
+        float integrated; // LUFS, gated, since the last reset
+        float true_peak;  // dBTP, maximum since the last reset
+    };
+
+private:
+    static constexpr int VECTORS = (MAX_AUDIO_CHANNELS + 3) / 4;
+    static constexpr int TP_TAPS = 12;   // Per phase
+    static constexpr int TP_PHASES = 4;  // 4x oversampling
+    static constexpr int SHORT_BLOCKS = 30;
+    static constexpr int MOMENTARY_BLOCKS = 4;
+    static constexpr int HISTOGRAM_BINS = 750; // -70 to +5 LUFS in 0.1 LU steps
+
+    uint32_t m_channels {}, m_block_frames {}, m_block_pos {};
+    int m_vectors {};
+
+    // Filter coefficients: shelf and high-pass biquads, b0 b1 b2 a1 a2 each
+    float m_shelf[5] {}, m_highpass[5] {};
+    float m_tp_coef[TP_PHASES][TP_TAPS] {};
+
+    // Per vector state, four channels each
+    struct alignas(16) State {
+        float z[4][4];                  // Two transposed direct form II stages, z1 z2 each
+        float energy[4];                // Sum of squares in the current block
+        float peak[4];                  // Absolute true peak since the last reset
+        float history[2 * TP_TAPS][4];  // Oversampler input, stored twice so the window is contiguous
+    } m_state[VECTORS] {};
+    int m_history_pos {};
+    float m_weights[VECTORS * 4] {};
+
+    float m_blocks[SHORT_BLOCKS] {}; // Weighted power of the last 100 ms blocks
+    uint64_t m_block_count {};
+    std::vector<uint32_t> m_histogram; // Gating blocks per bin
+    std::vector<double> m_bin_power;   // Summed power of those blocks, keeps the result exact
+
+    std::atomic<float> m_momentary, m_short_term, m_integrated, m_true_peak;
+    std::atomic<bool> m_reset_integrated {};
+
+    void ProcessVector(State& s, float const* samples, uint32_t frames, int first_channel);
+    void FinishBlock();
+    void ClearIntegrated();
+    float Integrated() const;
+
+public:
+    LoudnessMeter();
+
+    void Reset(uint32_t channels, uint32_t sample_rate, speaker_layout speakers) override;
+    void Process(float const* samples, uint32_t frames) override;
+
+    /// Any thread, takes effect with the next block
+    void ResetIntegrated() { m_reset_integrated = true; }
+
+    /// Any thread, -inf until enough audio arrived
+    Readings Read() const;
+};
@@ -0,0 +1,205 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "meter_bank.hpp"
+#include <cmath>
+#include <graphics/math-defs.h>
+#include <util/sse-intrin.h>
+
+// This file is compiled without floating point contraction (see CMakeLists.txt),
+// the SIMD kernel has to produce the exact same bits as StepScalar. tools/ballistics_bench
+// checks that, build it with BUILD_BALLISTICS_BENCH after changing either of them
+
+#define CLAMP(x, min, max) ((x) < (min) ? (min) : ((x) > (max) ? (max) : (x)))
+#define LANE_WIDTH 4
+
+void MeterBank::Lanes::Resize(size_t n)
+{
+    for (auto* v : { &current_peak, &current_input_peak, &current_magnitude, &peak, &peak_hold, &peak_hold_age,
+             &input_peak_hold, &input_peak_hold_age, &magnitude, &minimum_level, &peak_decay_rate,
+             &magnitude_integration_time, &peak_hold_duration, &input_peak_hold_duration })
+        v->resize(n);
+}
+
+void MeterBank::ResetLane(int lane)
+{
+    auto& l = m_lanes;
+    l.current_peak[lane] = -M_INFINITE;
+    l.current_input_peak[lane] = -M_INFINITE;
+    l.current_magnitude[lane] = -M_INFINITE;
+    l.peak[lane] = -M_INFINITE;
+    l.peak_hold[lane] = -M_INFINITE;
+    l.peak_hold_age[lane] = 0;
+    l.input_peak_hold[lane] = -M_INFINITE;
+    l.input_peak_hold_age[lane] = 0;
+    l.magnitude[lane] = -M_INFINITE;
+}
+
+int MeterBank::Allocate(Params const& p)
+{
+    int lane;
+    {
+        std::lock_guard<std::mutex> lock(m_free_mutex);
+        if (m_free.empty()) {
+            // Grow by a whole SIMD vector and put the new lanes on the free list
+            auto size = m_lanes.Size();
+            m_lanes.Resize(size + LANE_WIDTH);
+            for (size_t i = size + LANE_WIDTH; i > size; i--) {
+                m_free.emplace_back(int(i - 1));
+                ResetLane(int(i - 1));
+                // Unused lanes still run through the kernel, keep them well defined
+                m_lanes.minimum_level[i - 1] = p.minimum_level;
+                m_lanes.magnitude_integration_time[i - 1] = p.magnitude_integration_time;
+            }
+        }
+        lane = m_free.back();
+        m_free.pop_back();
+    }
+
+    ResetLane(lane);
+    m_lanes.minimum_level[lane] = p.minimum_level;
+    m_lanes.peak_decay_rate[lane] = p.peak_decay_rate;
+    m_lanes.magnitude_integration_time[lane] = p.magnitude_integration_time;
+    m_lanes.peak_hold_duration[lane] = p.peak_hold_duration;
+    m_lanes.input_peak_hold_duration[lane] = p.input_peak_hold_duration;
+    return lane;
+}
+
+void MeterBank::Release(int lane)
+{
+    std::lock_guard<std::mutex> lock(m_free_mutex);
+    m_free.emplace_back(lane);
+}
+
+void MeterBank::StepScalar(Lanes& l, size_t begin, size_t end, float dt)
+{
+    for (size_t i = begin; i < end; i++) {
+        const float current_peak = l.current_peak[i];
+        const float current_input_peak = l.current_input_peak[i];
+        const float current_magnitude = l.current_magnitude[i];
+
+        if (current_peak >= l.peak[i] || std::isnan(l.peak[i])) {
+            // Attack of peak is immediate.
+            l.peak[i] = current_peak;
+        } else {
+            // Decay of peak is 40 dB / 1.7 seconds for Fast Profile
+            // 20 dB / 1.7 seconds for Medium Profile (Type I PPM)
+            // 24 dB / 2.8 seconds for Slow Profile (Type II PPM)
+            float decay = l.peak_decay_rate[i] * dt;
+            l.peak[i] = CLAMP(l.peak[i] - decay, current_peak, 0.f);
+        }
+
+        l.peak_hold_age[i] += dt;
+        if (current_peak >= l.peak_hold[i] || !std::isfinite(l.peak_hold[i]) || l.peak_hold_age[i] > l.peak_hold_duration[i]) {
+            // Attack of peak-hold is immediate, the peak and hold
+            // falls back to peak after 20 seconds.
+            l.peak_hold[i] = current_peak;
+            l.peak_hold_age[i] = 0;
+        }
+
+        l.input_peak_hold_age[i] += dt;
+        if (current_input_peak >= l.input_peak_hold[i] || !std::isfinite(l.input_peak_hold[i])
+            || l.input_peak_hold_age[i] > l.input_peak_hold_duration[i]) {
+            // Attack of peak-hold is immediate, the peak and hold
+            // falls back to peak after 1 second.
+            l.input_peak_hold[i] = current_input_peak;
+            l.input_peak_hold_age[i] = 0;
+        }
+
+        if (!std::isfinite(l.magnitude[i])) {
+            // The statements in the else-leg do not work with
+            // NaN and infinite displayMagnitude.
+            l.magnitude[i] = current_magnitude;
+        } else {
+            // A VU meter will integrate to the new value to 99% in 300 ms.
+            // The calculation here is very simplified and is more accurate
+            // with higher frame-rate.
+            float attack = (current_magnitude - l.magnitude[i]) * (dt / l.magnitude_integration_time[i]) * 0.99f;
+            l.magnitude[i] = CLAMP(l.magnitude[i] + attack, l.minimum_level[i], 0.f);
+        }
+    }
+}
+
+static inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Same as CLAMP(), NaN passes through like in the scalar version
+static inline __m128 clamp(__m128 x, __m128 min, __m128 max)
+{
+    return select(_mm_cmplt_ps(x, min), min, select(_mm_cmpgt_ps(x, max), max, x));
+}
+
+static inline __m128 is_finite(__m128 x)
+{
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    return _mm_cmplt_ps(_mm_and_ps(x, abs_mask), _mm_set1_ps(INFINITY));
+}
+
+void MeterBank::StepSimd(Lanes& l, size_t end, float dt)
+{
+    const __m128 vdt = _mm_set1_ps(dt);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 vu_factor = _mm_set1_ps(0.99f);
+
+    for (size_t i = 0; i + LANE_WIDTH <= end; i += LANE_WIDTH) {
+        const __m128 current_peak = _mm_loadu_ps(&l.current_peak[i]);
+        const __m128 current_input_peak = _mm_loadu_ps(&l.current_input_peak[i]);
+        const __m128 current_magnitude = _mm_loadu_ps(&l.current_magnitude[i]);
+
+        // Peak: immediate attack, linear decay
+        __m128 peak = _mm_loadu_ps(&l.peak[i]);
+        __m128 attack = _mm_or_ps(_mm_cmpge_ps(current_peak, peak), _mm_cmpunord_ps(peak, peak));
+        __m128 decayed = clamp(_mm_sub_ps(peak, _mm_mul_ps(_mm_loadu_ps(&l.peak_decay_rate[i]), vdt)), current_peak, zero);
+        _mm_storeu_ps(&l.peak[i], select(attack, current_peak, decayed));
+
+        // Peak hold
+        __m128 hold = _mm_loadu_ps(&l.peak_hold[i]);
+        __m128 age = _mm_add_ps(_mm_loadu_ps(&l.peak_hold_age[i]), vdt);
+        __m128 refresh = _mm_or_ps(_mm_or_ps(_mm_cmpge_ps(current_peak, hold), _mm_xor_ps(is_finite(hold), _mm_cmpeq_ps(zero, zero))),
+            _mm_cmpgt_ps(age, _mm_loadu_ps(&l.peak_hold_duration[i])));
+        _mm_storeu_ps(&l.peak_hold[i], select(refresh, current_peak, hold));
+        _mm_storeu_ps(&l.peak_hold_age[i], select(refresh, zero, age));
+
+        // Input peak hold
+        hold = _mm_loadu_ps(&l.input_peak_hold[i]);
+        age = _mm_add_ps(_mm_loadu_ps(&l.input_peak_hold_age[i]), vdt);
+        refresh = _mm_or_ps(_mm_or_ps(_mm_cmpge_ps(current_input_peak, hold), _mm_xor_ps(is_finite(hold), _mm_cmpeq_ps(zero, zero))),
+            _mm_cmpgt_ps(age, _mm_loadu_ps(&l.input_peak_hold_duration[i])));
+        _mm_storeu_ps(&l.input_peak_hold[i], select(refresh, current_input_peak, hold));
+        _mm_storeu_ps(&l.input_peak_hold_age[i], select(refresh, zero, age));
+
+        // VU integration
+        __m128 magnitude = _mm_loadu_ps(&l.magnitude[i]);
+        __m128 rate = _mm_div_ps(vdt, _mm_loadu_ps(&l.magnitude_integration_time[i]));
+        __m128 vu_attack = _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(current_magnitude, magnitude), rate), vu_factor);
+        __m128 integrated = clamp(_mm_add_ps(magnitude, vu_attack), _mm_loadu_ps(&l.minimum_level[i]), zero);
+        _mm_storeu_ps(&l.magnitude[i], select(is_finite(magnitude), integrated, current_magnitude));
+    }
+}
+
+void MeterBank::Step(uint64_t ts)
+{
+    float dt = m_last_step_time ? (ts - m_last_step_time) * 0.000000001f : 0.f;
+    m_last_step_time = ts;
+
+    auto size = m_lanes.Size();
+    auto simd_end = size - size % LANE_WIDTH;
+    StepSimd(m_lanes, simd_end, dt);
+    StepScalar(m_lanes, simd_end, size, dt);
+}
@@ -0,0 +1,85 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Ballistics state of every meter channel in a layout, stored as
+// structure of arrays so all channels can be advanced in one SIMD pass.
+// Each meter channel owns one lane, lanes are recycled through a free list.
+class MeterBank {
+public:
+    struct Params {
+        float minimum_level;
+        float peak_decay_rate;
+        float magnitude_integration_time;
+        float peak_hold_duration;
+        float input_peak_hold_duration;
+    };
+
+    // One array per field, padded to a multiple of four lanes
+    struct Lanes {
+        std::vector<float> current_peak, current_input_peak, current_magnitude;
+        std::vector<float> peak, peak_hold, peak_hold_age;
+        std::vector<float> input_peak_hold, input_peak_hold_age, magnitude;
+        std::vector<float> minimum_level, peak_decay_rate, magnitude_integration_time;
+        std::vector<float> peak_hold_duration, input_peak_hold_duration;
+
+        size_t Size() const { return peak.size(); }
+        void Resize(size_t n);
+    };
+
+private:
+    Lanes m_lanes;
+    std::vector<int> m_free;
+    std::mutex m_free_mutex;
+    uint64_t m_last_step_time {};
+
+    void ResetLane(int lane);
+
+public:
+    /// Reference implementation, also used for lanes the SIMD kernel does not cover
+    static void StepScalar(Lanes& l, size_t begin, size_t end, float dt);
+    static void StepSimd(Lanes& l, size_t end, float dt);
+
+    /// Render thread only
+    int Allocate(Params const& p);
+
+    /// Can be called from any thread, the lane is reset when it is handed out again
+    void Release(int lane);
+
+    /// Render thread only
+    void SetLevels(int lane, float magnitude, float peak, float input_peak)
+    {
+        m_lanes.current_magnitude[lane] = magnitude;
+        m_lanes.current_peak[lane] = peak;
+        m_lanes.current_input_peak[lane] = input_peak;
+    }
+
+    void Reset(int lane) { ResetLane(lane); }
+
+    float CurrentPeak(int lane) const { return m_lanes.current_peak[lane]; }
+    float Peak(int lane) const { return m_lanes.peak[lane]; }
+    float PeakHold(int lane) const { return m_lanes.peak_hold[lane]; }
+    float InputPeakHold(int lane) const { return m_lanes.input_peak_hold[lane]; }
+    float Magnitude(int lane) const { return m_lanes.magnitude[lane]; }
+
+    /// Advances all lanes by the time since the last step, once per frame
+    void Step(uint64_t ts);
+};
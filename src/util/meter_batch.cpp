@@ -0,0 +1,302 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "meter_batch.hpp"
+#include "util.h"
+#include <algorithm>
+#include <cstring>
+#include <graphics/matrix4.h>
+#include <util/platform.h>
+#include <util/util.hpp>
+
+#define META_TEXELS 3
+#define ROW_TEXELS (META_TEXELS + MAX_AUDIO_CHANNELS)
+#define VERTICES_PER_METER 6
+
+static_assert(sizeof(MeterBatch::Instance) == ROW_TEXELS * sizeof(vec4), "Meter row has to match the data texture layout");
+
+static struct {
+    gs_effect_t* effect {};
+    gs_eparam_t* data {};
+    gs_eparam_t* thresholds {};
+    gs_eparam_t* minimum_input_level {};
+    gs_eparam_t* background_nominal {};
+    gs_eparam_t* background_warning {};
+    gs_eparam_t* background_error {};
+    gs_eparam_t* foreground_nominal {};
+    gs_eparam_t* foreground_warning {};
+    gs_eparam_t* foreground_error {};
+    gs_eparam_t* background_nominal_disabled {};
+    gs_eparam_t* background_warning_disabled {};
+    gs_eparam_t* background_error_disabled {};
+    gs_eparam_t* foreground_nominal_disabled {};
+    gs_eparam_t* foreground_warning_disabled {};
+    gs_eparam_t* foreground_error_disabled {};
+    gs_eparam_t* magnitude_color {};
+    gs_eparam_t* clip_color {};
+} meter_effect = {};
+
+void MeterBatch::Init()
+{
+    BPtr<char> effect_path = obs_module_file("volume.effect");
+    char* errors = nullptr;
+
+    obs_enter_graphics();
+    meter_effect.effect = gs_effect_create_from_file(effect_path, &errors);
+    if (meter_effect.effect) {
+#define GET_PARAM(p, name) meter_effect.p = gs_effect_get_param_by_name(meter_effect.effect, name)
+        GET_PARAM(data, "meter_data");
+        GET_PARAM(thresholds, "meter_thresholds");
+        GET_PARAM(minimum_input_level, "minimum_input_level");
+        GET_PARAM(background_nominal, "background_nominal");
+        GET_PARAM(background_warning, "background_warning");
+        GET_PARAM(background_error, "background_error");
+        GET_PARAM(foreground_nominal, "foreground_nominal");
+        GET_PARAM(foreground_warning, "foreground_warning");
+        GET_PARAM(foreground_error, "foreground_error");
+        GET_PARAM(background_nominal_disabled, "background_nominal_disabled");
+        GET_PARAM(background_warning_disabled, "background_warning_disabled");
+        GET_PARAM(background_error_disabled, "background_error_disabled");
+        GET_PARAM(foreground_nominal_disabled, "foreground_nominal_disabled");
+        GET_PARAM(foreground_warning_disabled, "foreground_warning_disabled");
+        GET_PARAM(foreground_error_disabled, "foreground_error_disabled");
+        GET_PARAM(magnitude_color, "magnitude_color");
+        GET_PARAM(clip_color, "clip_color");
+#undef GET_PARAM
+    } else {
+        berr("Failed to load volume meter effect from '%s': %s", effect_path.Get(), errors ? errors : "unknown error");
+    }
+    obs_leave_graphics();
+    bfree(errors);
+}
+
+void MeterBatch::Deinit()
+{
+    obs_enter_graphics();
+    gs_effect_destroy(meter_effect.effect);
+    obs_leave_graphics();
+    meter_effect = {};
+}
+
+MeterBatch::~MeterBatch()
+{
+    if (m_data || m_vertices) {
+        obs_enter_graphics();
+        gs_texture_destroy(m_data);
+        gs_vertexbuffer_destroy(m_vertices);
+        obs_leave_graphics();
+    }
+}
+
+bool MeterBatch::EnsureCapacity(uint32_t meters)
+{
+    if (meters <= m_capacity && m_data && m_vertices)
+        return true;
+
+    uint32_t capacity = std::max(m_capacity, 16u);
+    while (capacity < meters)
+        capacity *= 2;
+
+    gs_texture_destroy(m_data);
+    gs_vertexbuffer_destroy(m_vertices);
+    m_data = nullptr;
+    m_vertices = nullptr;
+    m_capacity = 0;
+
+    m_data = gs_texture_create(ROW_TEXELS, capacity, GS_RGBA32F, 1, nullptr, GS_DYNAMIC);
+    m_textures.Resize(m_data_cx, m_data_cy, m_data ? ROW_TEXELS : 0, m_data ? capacity : 0, sizeof(vec4));
+
+    auto* vbd = gs_vbdata_create();
+    vbd->num = capacity * VERTICES_PER_METER;
+    vbd->points = (vec3*)bzalloc(sizeof(vec3) * vbd->num);
+    vbd->num_tex = 1;
+    vbd->tvarray = (gs_tvertarray*)bzalloc(sizeof(gs_tvertarray));
+    vbd->tvarray[0].width = 4;
+    vbd->tvarray[0].array = bzalloc(sizeof(vec4) * vbd->num);
+    m_vertices = gs_vertexbuffer_create(vbd, GS_DYNAMIC);
+
+    if (!m_data || !m_vertices) {
+        berr("Failed to create volume meter batch resources for %u meters", capacity);
+        return false;
+    }
+    m_capacity = capacity;
+    return true;
+}
+
+bool MeterBatch::Style::operator==(Style const& o) const
+{
+    return minimum_level == o.minimum_level && warning_level == o.warning_level && error_level == o.error_level
+        && clip_level == o.clip_level && minimum_input_level == o.minimum_input_level
+        && background_nominal == o.background_nominal && background_warning == o.background_warning
+        && background_error == o.background_error && foreground_nominal == o.foreground_nominal
+        && foreground_warning == o.foreground_warning && foreground_error == o.foreground_error
+        && background_nominal_disabled == o.background_nominal_disabled
+        && background_warning_disabled == o.background_warning_disabled
+        && background_error_disabled == o.background_error_disabled
+        && foreground_nominal_disabled == o.foreground_nominal_disabled
+        && foreground_warning_disabled == o.foreground_warning_disabled
+        && foreground_error_disabled == o.foreground_error_disabled && magnitude == o.magnitude && clip == o.clip;
+}
+
+// Corners of the rectangle after the current matrix, sorted
+static void TransformRect(float x, float y, float cx, float cy, vec4& out)
+{
+    matrix4 m;
+    gs_matrix_get(&m);
+
+    vec3 a, b;
+    vec3_set(&a, x, y, 0);
+    vec3_set(&b, x + cx, y + cy, 0);
+    vec3_transform(&a, &a, &m);
+    vec3_transform(&b, &b, &m);
+    vec4_set(&out, std::min(a.x, b.x), std::min(a.y, b.y), std::max(a.x, b.x), std::max(a.y, b.y));
+}
+
+void MeterBatch::Begin()
+{
+    m_instances.clear();
+    m_quads.clear();
+    m_runs.clear();
+
+    // Meters that are clipped away or hidden this frame still have to decay
+    m_bank.Step(os_gettime_ns());
+}
+
+void MeterBatch::SetClip(float x, float y, float cx, float cy)
+{
+    TransformRect(x, y, cx, cy, m_clip);
+}
+
+MeterBatch::Instance* MeterBatch::Add(float x, float y, float cx, float cy, Style const& style, int const* lanes, int lane_count)
+{
+    vec4 rect;
+    TransformRect(x, y, cx, cy, rect);
+    if (rect.z <= rect.x || rect.w <= rect.y)
+        return nullptr;
+
+    Quad q;
+    q.left = std::max(rect.x, m_clip.x);
+    q.top = std::max(rect.y, m_clip.y);
+    q.right = std::min(rect.z, m_clip.z);
+    q.bottom = std::min(rect.w, m_clip.w);
+    if (q.left >= q.right || q.top >= q.bottom)
+        return nullptr;
+
+    // The shader works in unscaled meter pixel coordinates, so clipping only moves the corners
+    const float sx = cx / (rect.z - rect.x), sy = cy / (rect.w - rect.y);
+    q.u0 = (q.left - rect.x) * sx;
+    q.v0 = (q.top - rect.y) * sy;
+    q.u1 = (q.right - rect.x) * sx;
+    q.v1 = (q.bottom - rect.y) * sy;
+    q.lane_count = std::min(lane_count, MAX_AUDIO_CHANNELS);
+    std::copy(lanes, lanes + q.lane_count, q.lanes);
+
+    if (m_runs.empty() || m_runs.back().style != style)
+        m_runs.push_back({ style, uint32_t(m_instances.size()), 0 });
+    m_runs.back().count++;
+    m_quads.emplace_back(q);
+    return &m_instances.emplace_back();
+}
+
+void MeterBatch::Flush()
+{
+    if (m_instances.empty())
+        return;
+    if (meter_effect.effect && EnsureCapacity(uint32_t(m_instances.size())))
+        Submit();
+    m_instances.clear();
+    m_quads.clear();
+    m_runs.clear();
+}
+
+void MeterBatch::Submit()
+{
+    auto count = uint32_t(m_instances.size());
+
+    for (uint32_t i = 0; i < count; i++) {
+        auto const& q = m_quads[i];
+        for (int c = 0; c < q.lane_count; c++) {
+            int lane = q.lanes[c];
+            vec4_set(&m_instances[i].levels[c], m_bank.Peak(lane), m_bank.PeakHold(lane), m_bank.Magnitude(lane),
+                m_bank.InputPeakHold(lane));
+        }
+    }
+
+    uint8_t* ptr = nullptr;
+    uint32_t linesize = 0;
+    if (!gs_texture_map(m_data, &ptr, &linesize))
+        return;
+    for (uint32_t i = 0; i < count; i++)
+        memcpy(ptr + i * linesize, &m_instances[i], sizeof(Instance));
+    gs_texture_unmap(m_data);
+
+    auto* vbd = gs_vertexbuffer_get_data(m_vertices);
+    auto* uv = static_cast<vec4*>(vbd->tvarray[0].array);
+    for (uint32_t i = 0; i < count; i++) {
+        auto const& q = m_quads[i];
+        auto* p = vbd->points + i * VERTICES_PER_METER;
+        auto* t = uv + i * VERTICES_PER_METER;
+        float row = float(i);
+
+        vec3_set(&p[0], q.left, q.top, 0);
+        vec3_set(&p[1], q.right, q.top, 0);
+        vec3_set(&p[2], q.left, q.bottom, 0);
+        vec3_set(&p[3], q.left, q.bottom, 0);
+        vec3_set(&p[4], q.right, q.top, 0);
+        vec3_set(&p[5], q.right, q.bottom, 0);
+        vec4_set(&t[0], q.u0, q.v0, row, 0);
+        vec4_set(&t[1], q.u1, q.v0, row, 0);
+        vec4_set(&t[2], q.u0, q.v1, row, 0);
+        vec4_set(&t[3], q.u0, q.v1, row, 0);
+        vec4_set(&t[4], q.u1, q.v0, row, 0);
+        vec4_set(&t[5], q.u1, q.v1, row, 0);
+    }
+    gs_vertexbuffer_flush(m_vertices);
+
+    // The quads were transformed when they were queued
+    gs_matrix_push();
+    gs_matrix_identity();
+    gs_load_vertexbuffer(m_vertices);
+    gs_load_indexbuffer(nullptr);
+    gs_effect_set_texture(meter_effect.data, m_data);
+    for (auto const& run : m_runs) {
+        auto const& s = run.style;
+        vec4 thresholds;
+        vec4_set(&thresholds, s.minimum_level, s.warning_level, s.error_level, s.clip_level);
+        gs_effect_set_vec4(meter_effect.thresholds, &thresholds);
+        gs_effect_set_float(meter_effect.minimum_input_level, s.minimum_input_level);
+        gs_effect_set_color(meter_effect.background_nominal, s.background_nominal);
+        gs_effect_set_color(meter_effect.background_warning, s.background_warning);
+        gs_effect_set_color(meter_effect.background_error, s.background_error);
+        gs_effect_set_color(meter_effect.foreground_nominal, s.foreground_nominal);
+        gs_effect_set_color(meter_effect.foreground_warning, s.foreground_warning);
+        gs_effect_set_color(meter_effect.foreground_error, s.foreground_error);
+        gs_effect_set_color(meter_effect.background_nominal_disabled, s.background_nominal_disabled);
+        gs_effect_set_color(meter_effect.background_warning_disabled, s.background_warning_disabled);
+        gs_effect_set_color(meter_effect.background_error_disabled, s.background_error_disabled);
+        gs_effect_set_color(meter_effect.foreground_nominal_disabled, s.foreground_nominal_disabled);
+        gs_effect_set_color(meter_effect.foreground_warning_disabled, s.foreground_warning_disabled);
+        gs_effect_set_color(meter_effect.foreground_error_disabled, s.foreground_error_disabled);
+        gs_effect_set_color(meter_effect.magnitude_color, s.magnitude);
+        gs_effect_set_color(meter_effect.clip_color, s.clip);
+
+        while (gs_effect_loop(meter_effect.effect, "Meter"))
+            gs_draw(GS_TRIS, run.first * VERTICES_PER_METER, run.count * VERTICES_PER_METER);
+    }
+    gs_load_vertexbuffer(nullptr);
+    gs_matrix_pop();
+}
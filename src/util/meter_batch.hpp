@@ -0,0 +1,111 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#pragma once
+#include "meter_bank.hpp"
+#include "resource_usage.hpp"
+#include <cstdint>
+#include <graphics/vec4.h>
+#include <obs-module.h>
+#include <vector>
+
+// Collects the volume meters an item queues while it renders and draws
+// them with one draw call per style when the item flushes. Per-meter data
+// is packed into one row of a float texture, indexed by the meter quad.
+// Flushing per item keeps meters in the z-order the item draws them in.
+class MeterBatch {
+public:
+    // One texture row, the layout has to match volume.effect
+    struct Instance {
+        vec4 geometry; // x: channel count, y: channel width, z: channel stride, w: bar height
+        vec4 state;    // x: muted, y: clipping, z: idle, w: peak hold/magnitude marker size
+        vec4 extra;    // x: gap between bar and input peak indicator
+        vec4 levels[MAX_AUDIO_CHANNELS]; // x: peak, y: peak hold, z: magnitude, w: input peak hold (dB)
+    };
+
+    // Uniforms of the meter effect, consecutive meters with the same style share one draw
+    struct Style {
+        float minimum_level, warning_level, error_level, clip_level, minimum_input_level;
+        uint32_t background_nominal, background_warning, background_error;
+        uint32_t foreground_nominal, foreground_warning, foreground_error;
+        uint32_t background_nominal_disabled, background_warning_disabled, background_error_disabled;
+        uint32_t foreground_nominal_disabled, foreground_warning_disabled, foreground_error_disabled;
+        uint32_t magnitude, clip;
+
+        bool operator==(Style const& o) const;
+        bool operator!=(Style const& o) const { return !(*this == o); }
+    };
+
+private:
+    struct Quad {
+        float left, top, right, bottom; // Layout coordinates, already clipped
+        float u0, v0, u1, v1;           // Meter pixel coordinates of the corners
+        int lanes[MAX_AUDIO_CHANNELS];  // Bank lanes the levels are read from
+        int lane_count;
+    };
+
+    struct Run {
+        Style style;
+        uint32_t first, count;
+    };
+
+    MeterBank m_bank;
+    std::vector<Instance> m_instances;
+    std::vector<Quad> m_quads;
+    std::vector<Run> m_runs;
+    vec4 m_clip {};
+
+    gs_texture_t* m_data {};
+    gs_vertbuffer_t* m_vertices {};
+    uint32_t m_capacity {};
+    uint32_t m_data_cx {}, m_data_cy {};
+    TextureTally m_textures;
+
+    bool EnsureCapacity(uint32_t meters);
+    void Submit();
+
+public:
+    MeterBatch() = default;
+    ~MeterBatch();
+
+    static void Init();
+    static void Deinit();
+
+    /// Once per frame before the item pass, advances the ballistics of all meters.
+    /// Levels read during a frame are integrated at the start of the next one
+    void Begin();
+
+    /// Meters added after this are clipped to this rectangle, given in the current matrix space
+    void SetClip(float x, float y, float cx, float cy);
+
+    /// Queues a meter quad at x/y in the current matrix space, returns nullptr if it is clipped away.
+    /// The matrix may translate and scale, but not rotate. The levels of the instance are
+    /// filled from the given bank lanes when the batch is flushed
+    Instance* Add(float x, float y, float cx, float cy, Style const& style, int const* lanes, int lane_count);
+
+    /// Draws all queued meters, the caller decides the z-order by when it flushes.
+    /// Add() already moved the quads into layout (ortho) space with the model matrix of that
+    /// moment, so they are drawn under an identity model matrix and the current projection
+    void Flush();
+
+    MeterBank& Bank() { return m_bank; }
+
+    /// Any thread
+    void AccountResources(ResourceUsage& usage) const { m_textures.Account(usage); }
+
+    size_t Count() const { return m_instances.size(); }
+};
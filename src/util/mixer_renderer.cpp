@@ -19,93 +19,100 @@
 #include "mixer_renderer.hpp"
 #include "../items/audio_mixer.hpp"
 #include "../items/source_item.hpp"
+#include <algorithm>
 #include <obs-frontend-api.h>
+#include <util/profiler.hpp>
 
-static void fader_update(void* data, float db)
-{
-    static_cast<MixerSlider*>(data)->SetDb(db);
-}
+// Space left of the first slider and the room a slider needs next to its meter
+#define MIXER_LEFT 35
+#define MIXER_SLIDER_ROOM 28
+#define MIXER_LABEL_ROOM 20
 
-void MixerSlider::OnSourceNameChanged()
-{
-    m_parent->QueueSourceUpdate();
-}
-
-MixerSlider::MixerSlider(AudioMixerRenderer* parent, OBSSource src, int x, int y, int height, int channel_width)
+MixerSlider::MixerSlider(OBSSource src, int x, int y, int height, int channel_width)
     : MixerMeter(src, x, y, height, channel_width)
-    , m_parent(parent)
-{
-}
-
-MixerSlider::~MixerSlider()
 {
-    // Detach from source first to prevent callbacks during destruction
-    if (m_fader) {
-        obs_fader_remove_callback(m_fader, fader_update, this);
-        obs_fader_detach_source(m_fader);
-        obs_fader_destroy(m_fader);
-    }
 }
 
-void MixerSlider::Render(float cell_scale, float source_scale_x, float source_scale_y)
+void MixerSlider::RenderControls(Geometry const& g, float cell_scale)
 {
-    MixerMeter::Render(cell_scale, source_scale_x, source_scale_y);
-
-    gs_matrix_push();
-    gs_matrix_translate3f(m_x - 2, m_y - 3, 0.0f);
-    gs_matrix_rotaa4f(0, 0, 1, RAD(90));
-    obs_source_video_render(m_label);
-    gs_matrix_pop();
-
     const int handle_width = 24;
     const int handle_height = 8;
     const int slider_width = 3 * 1.5;
-    m_mute_width = GetWidth();
-    m_mute_height = m_channel_width / cell_scale;
-    const int on_length = (m_height - handle_height) * GetSliderPosition();
+    const int meter_width = GetWidth(g.channel_width);
+    const int mute_height = g.channel_width / cell_scale;
+    const int on_length = (g.height - handle_height) * GetSliderPosition();
+
+    // Flashing frame around meter and slider
+    if (GetAlarm() != VolmeterHub::AudioAlarm::None && LayoutItem::FlashColor(1, 0)) {
+        const int left = g.x - 3, top = g.y - 3, right = g.x + meter_width + MIXER_SLIDER_ROOM, bottom = g.y + g.height + 3;
+        draw_rectangle(left, top, right - left, 2, COLOR_ALARM_AUDIO);
+        draw_rectangle(left, bottom - 2, right - left, 2, COLOR_ALARM_AUDIO);
+        draw_rectangle(left, top, 2, bottom - top, COLOR_ALARM_AUDIO);
+        draw_rectangle(right - 2, top, 2, bottom - top, COLOR_ALARM_AUDIO);
+    }
 
     // Slider line
     gs_matrix_push();
-    gs_matrix_translate3f(m_x + GetWidth() + 15 - slider_width / 2, m_y, 0.0f);
-    draw_rectangle(0, on_length, slider_width, m_height - on_length, ARGB32(255, 42, 130, 218));
+    gs_matrix_translate3f(g.x + meter_width + 15 - slider_width / 2, g.y, 0.0f);
+    draw_rectangle(0, on_length, slider_width, g.height - on_length, ARGB32(255, 42, 130, 218));
     draw_rectangle(0, 0, slider_width, on_length, ARGB32(255, 100, 100, 100));
     gs_matrix_pop();
 
     // Slider position
     gs_matrix_push();
-    gs_matrix_translate3f(m_x + GetWidth() + 15 - handle_width / 2, m_y + on_length, 0.0f);
+    gs_matrix_translate3f(g.x + meter_width + 15 - handle_width / 2, g.y + on_length, 0.0f);
     draw_rectangle(0, 0, handle_width, handle_height, ARGB32(255, 210, 210, 210));
     gs_matrix_pop();
 
     // mute/unmute
-    draw_rectangle(m_x, m_y + m_height - m_mute_height, m_mute_width, m_mute_height, m_muted ? ARGB32(255, 100, 100, 100) : m_foreground_nominal_color);
+    draw_rectangle(g.x, g.y + g.height - mute_height, meter_width, mute_height, m_muted ? ARGB32(255, 100, 100, 100) : m_foreground_nominal_color);
 }
 
 void MixerSlider::SetSource(OBSSource src)
 {
     MixerMeter::SetSource(src);
-    auto name = std::string(obs_source_get_name(src));
+    UpdateLabel();
+    SetDb(obs_fader_get_db(Fader()));
+}
+
+void MixerSlider::UpdateLabel()
+{
+    auto name = std::string(obs_source_get_name(m_source));
 
     if (name.length() > 30)
         name = name.substr(0, 27) + "...";
-    m_label = CreateLabel(name.c_str(), 140, 1);
+    auto label = CreateLabel(name.c_str(), 140, m_label_scale);
 
-    obs_fader_detach_source(m_fader);
-    obs_fader_attach_source(m_fader, m_source);
-    SetDb(obs_fader_get_db(m_fader));
+    std::lock_guard<std::mutex> lock(m_label_mutex);
+    m_label = label;
+    m_label_id = LabelAtlas::NextId();
+    m_label_font_scale = m_label_scale;
 }
 
-void MixerSlider::SetType(obs_fader_type t)
+void MixerSlider::SetLabelScale(float scale)
 {
-    MixerMeter::SetType(t);
+    if (scale <= 0 || scale == m_label_scale)
+        return;
+    m_label_scale = scale;
+    // Before SetSource() there's no label yet, it's created with this scale later
+    if (m_label_id)
+        UpdateLabel();
+}
 
-    obs_fader_remove_callback(m_fader, fader_update, this);
-    obs_fader_destroy(m_fader);
-    m_fader = obs_fader_create(t);
-    obs_fader_add_callback(m_fader, fader_update, this);
+void MixerSlider::QueueLabel(LabelAtlas& atlas, Geometry const& g)
+{
+    std::lock_guard<std::mutex> lock(m_label_mutex);
+    atlas.Add(m_label_id, m_label, m_label_font_scale, g.x - 2, g.y - 3);
 }
 
-void MixerSlider::MouseEvent(const LayoutItem::MouseData& e, const DurchblickItemConfig&, uint32_t mx, uint32_t my)
+void MixerSlider::AccountResources(ResourceUsage& usage)
+{
+    MixerMeter::AccountResources(usage);
+    std::lock_guard<std::mutex> lock(m_label_mutex);
+    usage.AddLabel(m_label);
+}
+
+void MixerSlider::MouseEvent(const LayoutItem::MouseData& e, const DurchblickItemConfig& cfg, uint32_t mx, uint32_t my)
 {
     if (e.buttons & Qt::LeftButton) {
         if (MouseOverSlider(mx, my)) {
@@ -115,16 +122,16 @@ void MixerSlider::MouseEvent(const LayoutItem::MouseData& e, const DurchblickIte
 
         if (m_dragging_volume) {
             auto fade = qBound(0.f, float(qMax(m_y, int(my)) - m_y) / m_height, 1.f);
-            obs_fader_set_deflection(m_fader, 1 - fade);
-            SetDb(obs_fader_get_db(m_fader));
+            obs_fader_set_deflection(Fader(), 1 - fade);
+            SetDb(obs_fader_get_db(Fader()));
         }
 
-        if (MouseOverMuteArea(mx, my) && e.type == QEvent::MouseButtonPress)
+        if (MouseOverMuteArea(mx, my, cfg.scale) && e.type == QEvent::MouseButtonPress)
             m_lmb_down = true;
 
     } else {
         m_dragging_volume = false;
-        if (!MouseOverMuteArea(mx, my))
+        if (!MouseOverMuteArea(mx, my, cfg.scale))
             m_lmb_down = false;
     }
 
@@ -134,102 +141,376 @@ void MixerSlider::MouseEvent(const LayoutItem::MouseData& e, const DurchblickIte
     }
 }
 
-void AudioMixerRenderer::RefreshSliderSizeAndPos()
-{
-    for (auto& slider : m_sliders) {
-        slider->SetY(m_y);
-        slider->SetHeight(m_height);
-    }
-}
+// Sliders kept alive on either side of the visible window, so scrolling
+// by a notch doesn't have to wait for new volmeters to report
+#define MIXER_MARGIN_SLOTS 2
 
 AudioMixerRenderer::AudioMixerRenderer(AudioMixerItem* parent, int height, int channel_width)
     : m_height(height)
     , m_channel_width(channel_width)
     , m_parent(parent)
 {
-    UpdateSources();
+    // Initial population, afterwards the mixer only follows source signals
+    obs_enum_sources(
+        [](void* param, obs_source_t* src) {
+            static_cast<AudioMixerRenderer*>(param)->EvaluateSource(src);
+            return true;
+        },
+        this);
+    ConnectSignals();
+}
+
+AudioMixerRenderer::~AudioMixerRenderer()
+{
+    // Make sure no signal handler runs while the sliders are torn down
+    m_signals.clear();
 }
 
-void AudioMixerRenderer::UpdateSources()
+void AudioMixerRenderer::ConnectSignals()
 {
-    m_sliders.clear();
+    // Global signals arrive on arbitrary threads, the mixer is only changed on the UI thread
+    auto* handler = obs_get_signal_handler();
+
+    signal_callback_t evaluate = [](void* d, calldata_t* cd) {
+        auto* mixer = static_cast<AudioMixerRenderer*>(d);
+        OBSWeakSource weak = OBSGetWeakRef(static_cast<obs_source_t*>(calldata_ptr(cd, "source")));
+        QMetaObject::invokeMethod(
+            mixer->m_parent, [mixer, weak]() {
+                OBSSourceAutoRelease src = obs_weak_source_get_source(weak);
+                if (src)
+                    mixer->EvaluateSource(src);
+            },
+            Qt::QueuedConnection);
+    };
+    for (auto const* signal : { "source_create", "source_activate", "source_deactivate", "source_audio_activate",
+             "source_audio_deactivate" })
+        m_signals.emplace_back(handler, signal, evaluate, this);
+
+    m_signals.emplace_back(
+        handler, "source_rename", [](void* d, calldata_t* cd) {
+            auto* mixer = static_cast<AudioMixerRenderer*>(d);
+            OBSWeakSource weak = OBSGetWeakRef(static_cast<obs_source_t*>(calldata_ptr(cd, "source")));
+            QMetaObject::invokeMethod(
+                mixer->m_parent, [mixer, weak]() {
+                    OBSSourceAutoRelease src = obs_weak_source_get_source(weak);
+                    if (src)
+                        mixer->RenameSource(src);
+                },
+                Qt::QueuedConnection);
+        },
+        this);
+
+    m_signals.emplace_back(
+        handler, "source_remove", [](void* d, calldata_t* cd) {
+            auto* mixer = static_cast<AudioMixerRenderer*>(d);
+            OBSWeakSource weak = OBSGetWeakRef(static_cast<obs_source_t*>(calldata_ptr(cd, "source")));
+            QMetaObject::invokeMethod(
+                mixer->m_parent, [mixer, weak]() {
+                    mixer->m_hidden.erase(weak.Get());
+                    // Members hold a reference, so a source that is already gone wasn't one
+                    OBSSourceAutoRelease src = obs_weak_source_get_source(weak);
+                    if (src)
+                        mixer->RemoveSource(src);
+                },
+                Qt::QueuedConnection);
+        },
+        this);
+}
 
-    /* We keep global audio sources in the front
-     * because I thought that that's what the mixer in obs does, but then
-     * i found out that it doesn't do that and i already wrote the code
-     */
-    struct data {
-        std::vector<OBSSource> active_audio_srcs;
-        std::vector<OBSSource> active_global_audio_srcs;
-        QString desktop_string = QApplication::translate("", "Basic.DesktopDevice1");
-        QString mic_string = QApplication::translate("", "Basic.AuxDevice1");
-    } d;
+/* We keep global audio sources in the front
+ * because I thought that that's what the mixer in obs does, but then
+ * i found out that it doesn't do that and i already wrote the code
+ */
+bool AudioMixerRenderer::EntryLess(Entry const& a, Entry const& b)
+{
+    if (a.global != b.global)
+        return a.global;
+    return a.sort_key < b.sort_key;
+}
 
-    obs_enum_sources(
-        [](void* param, obs_source_t* src) {
-            uint32_t flags = obs_source_get_output_flags(src);
-
-            if ((flags & OBS_SOURCE_AUDIO) != 0 && obs_source_active(src)) {
-                OBSDataAutoRelease priv_settings = obs_source_get_private_settings(src);
-                bool hidden = obs_data_get_bool(priv_settings, "mixer_hidden");
-
-                auto* d = static_cast<data*>(param);
-                if (obs_source_audio_active(src) && !hidden) {
-                    auto name = utf8_to_qt(obs_source_get_name(src));
-                    if (name.startsWith(d->desktop_string) || name.startsWith(d->mic_string)) {
-                        d->active_global_audio_srcs.emplace_back(src);
-                    } else {
-                        d->active_audio_srcs.emplace_back(src);
-                    }
-                }
-            }
-            return true;
-        },
-        &d);
+void AudioMixerRenderer::UpdateSortKey(Entry& e)
+{
+    static const QString desktop_string = QApplication::translate("", "Basic.DesktopDevice1");
+    static const QString mic_string = QApplication::translate("", "Basic.AuxDevice1");
 
-    std::sort(d.active_audio_srcs.begin(), d.active_audio_srcs.end(), [](auto const& a, auto const& b) {
-        return utf8_to_qt(obs_source_get_name(a)).toLower() < utf8_to_qt(obs_source_get_name(b)).toLower();
-    });
-    std::sort(d.active_global_audio_srcs.begin(), d.active_global_audio_srcs.end(), [](auto const& a, auto const& b) {
-        return utf8_to_qt(obs_source_get_name(a)).toLower() < utf8_to_qt(obs_source_get_name(b)).toLower();
+    auto name = utf8_to_qt(obs_source_get_name(e.source));
+    e.global = name.startsWith(desktop_string) || name.startsWith(mic_string);
+    e.sort_key = name.toLower();
+}
+
+std::vector<AudioMixerRenderer::Entry>::iterator AudioMixerRenderer::Find(obs_source_t* src)
+{
+    return std::find_if(m_entries.begin(), m_entries.end(), [src](Entry const& e) {
+        return e.source.Get() == src;
     });
+}
+
+void AudioMixerRenderer::Insert(Entry&& e)
+{
+    auto it = std::upper_bound(m_entries.begin(), m_entries.end(), e, EntryLess);
+    m_entries.insert(it, std::move(e));
+}
+
+bool AudioMixerRenderer::IsHidden(obs_source_t* src)
+{
+    OBSDataAutoRelease priv_settings = obs_source_get_private_settings(src);
+    return obs_data_get_bool(priv_settings, "mixer_hidden");
+}
 
-    int x = 35;
+void AudioMixerRenderer::EvaluateSource(obs_source_t* src)
+{
+    uint32_t flags = obs_source_get_output_flags(src);
+    bool eligible = (flags & OBS_SOURCE_AUDIO) != 0 && obs_source_active(src) && obs_source_audio_active(src)
+        && !obs_source_removed(src) && !obs_obj_is_private(src);
+
+    OBSWeakSource weak = OBSGetWeakRef(src);
+    if (eligible && !IsHidden(src)) {
+        m_hidden.erase(weak.Get());
+        AddSource(src);
+    } else {
+        RemoveSource(src);
+        if (eligible)
+            m_hidden.emplace(weak.Get(), weak);
+        else
+            m_hidden.erase(weak.Get());
+    }
+}
+
+void AudioMixerRenderer::RecheckHidden()
+{
+    ProfileScope("AudioMixerRenderer::RecheckHidden");
+    std::vector<OBSSource> sources;
+    for (auto const& e : m_entries) {
+        if (IsHidden(e.source))
+            sources.emplace_back(e.source);
+    }
+
+    for (auto it = m_hidden.begin(); it != m_hidden.end();) {
+        OBSSourceAutoRelease src = obs_weak_source_get_source(it->second);
+        if (!src) {
+            it = m_hidden.erase(it);
+            continue;
+        }
+        if (!IsHidden(src))
+            sources.emplace_back(src.Get());
+        ++it;
+    }
+
+    for (auto const& src : sources)
+        EvaluateSource(src);
+}
+
+void AudioMixerRenderer::AddSource(obs_source_t* src)
+{
+    if (!src || m_members.count(src))
+        return;
+
+    Entry e;
+    e.source = src;
+    UpdateSortKey(e);
+    Insert(std::move(e));
+    m_members.insert(src);
+    Publish();
+}
+
+void AudioMixerRenderer::RemoveSource(obs_source_t* src)
+{
+    if (!m_members.erase(src))
+        return;
+    auto it = Find(src);
+    if (it != m_entries.end())
+        m_entries.erase(it);
+    Publish();
+}
+
+void AudioMixerRenderer::RenameSource(obs_source_t* src)
+{
+    if (!m_members.count(src))
+        return;
+    auto it = Find(src);
+    if (it == m_entries.end())
+        return;
+
+    Entry e = std::move(*it);
+    m_entries.erase(it);
+    if (e.slider)
+        e.slider->UpdateLabel();
+    UpdateSortKey(e);
+    Insert(std::move(e));
+    Publish();
+}
+
+int AudioMixerRenderer::SlotWidth() const
+{
+    // Sliders aren't created for every entry, so all slots use the channel
+    // count of the audio output, which is what the volmeters report anyway
+    struct obs_audio_info oai;
+    int channels = 2;
+    if (obs_get_audio_info(&oai))
+        channels = qBound(1, int(get_audio_channels(oai.speakers)), MAX_AUDIO_CHANNELS);
+
+    const int meter_width = (m_channel_width + 2) * channels;
+    const int compact = meter_width + MIXER_SLIDER_ROOM + MIXER_LABEL_ROOM;
+    if (m_density == Compact)
+        return compact;
+    return qMax(int(m_channel_width * meter_width * 2.5), compact);
+}
+
+int AudioMixerRenderer::ContentWidth() const
+{
+    return MIXER_LEFT + SlotWidth() * int(m_entries.size());
+}
 
-    d.active_audio_srcs.insert(d.active_audio_srcs.begin(), d.active_global_audio_srcs.begin(), d.active_global_audio_srcs.end());
+void AudioMixerRenderer::Publish()
+{
+    ProfileScope("AudioMixerRenderer::Publish");
+    // Lay out on the UI thread, the render thread only swaps in the new view
+    const int view_width = m_parent->Width();
+    const int slot = SlotWidth();
+    const int content_width = ContentWidth();
+    const int count = int(m_entries.size());
+    m_scroll = qBound(0, m_scroll, qMax(0, content_width - view_width));
+
+    const int first = qMax(0, (m_scroll - MIXER_LEFT) / slot - MIXER_MARGIN_SLOTS);
+    const int last = qMin(count, (m_scroll + view_width - MIXER_LEFT) / slot + 1 + MIXER_MARGIN_SLOTS);
+
+    View view;
+    view.scroll = m_scroll;
+    view.content_width = content_width;
+    view.view_width = view_width;
+    view.bar_y = m_y + m_height + 4;
+    view.sliders.reserve(qMax(0, last - first));
+    for (int i = 0; i < count; i++) {
+        auto& e = m_entries[i];
+        if (i < first || i >= last) {
+            // The render thread may still draw it until it picks up the new view
+            e.slider.reset();
+            continue;
+        }
 
-    for (auto& src : d.active_audio_srcs) {
-        auto* slider = new MixerSlider(this, src, x, 0, m_height, m_channel_width);
-        slider->SetType(OBS_FADER_LOG);
-        slider->SetSource(src);
-        m_sliders.emplace_back(slider);
-        x += (m_channel_width * slider->GetWidth()) * 2.5;
+        if (!e.slider) {
+            e.slider = std::make_shared<MixerSlider>(e.source, 0, m_y, m_height, m_channel_width);
+            e.slider->SetLabelScale(m_label_scale);
+            e.slider->SetType(OBS_FADER_LOG);
+            e.slider->SetSource(e.source);
+        }
+        // The slider's own position is only used for hit testing on this thread,
+        // the render thread draws it where the view says
+        e.slider->SetPos(MIXER_LEFT + i * slot - m_scroll, m_y);
+        e.slider->SetHeight(m_height);
+        view.sliders.push_back({ e.slider, e.slider->GetGeometry() });
     }
+
+    std::lock_guard<std::mutex> lock(m_pending_mutex);
+    m_pending = std::move(view);
+    m_pending_valid = true;
 }
 
-void AudioMixerRenderer::Render(float cell_scale, float source_scale_x, float source_scale_y)
+void AudioMixerRenderer::Render(MeterBatch& batch, float cell_scale, float source_scale_x, float source_scale_y)
 {
-    for (auto& slider : m_sliders)
-        slider->Render(cell_scale, source_scale_x, source_scale_y);
+    std::vector<View::Slot> retired;
+    {
+        std::lock_guard<std::mutex> lock(m_pending_mutex);
+        if (m_pending_valid) {
+            retired = std::move(m_view.sliders);
+            m_view = std::move(m_pending);
+            m_pending = {};
+            m_pending_valid = false;
+        }
+    }
 
-    if (m_update_queued) {
-        m_update_queued = false;
-        UpdateSources();
-        RefreshSliderSizeAndPos();
+    // Removed sliders still hold a volmeter subscription and a text source,
+    // let the UI thread drop the last reference instead of stalling this frame
+    if (!retired.empty())
+        QMetaObject::invokeMethod(
+            m_parent, [retired = std::move(retired)]() mutable { retired.clear(); }, Qt::QueuedConnection);
+
+    // Labels are cached in an atlas and drawn together after the sliders
+    m_labels.Begin();
+    for (auto& s : m_view.sliders)
+        s.slider->Render(batch, s.geometry, cell_scale, source_scale_x, source_scale_y);
+    batch.Flush();
+    for (auto& s : m_view.sliders) {
+        s.slider->RenderControls(s.geometry, cell_scale);
+        s.slider->QueueLabel(m_labels, s.geometry);
+    }
+    m_labels.Draw();
+
+    // Scroll bar below the sliders
+    if (m_view.content_width > m_view.view_width && m_view.content_width > 0) {
+        const float thumb_width = qMax(8.f, float(m_view.view_width) * m_view.view_width / m_view.content_width);
+        const float thumb_x = float(m_view.scroll) / (m_view.content_width - m_view.view_width) * (m_view.view_width - thumb_width);
+        LayoutItem::DrawBox(0, m_view.bar_y, m_view.view_width, 3, ARGB32(255, 60, 60, 60));
+        LayoutItem::DrawBox(thumb_x, m_view.bar_y, thumb_width, 3, ARGB32(255, 160, 160, 160));
     }
 }
 
-void AudioMixerRenderer::Update(const DurchblickItemConfig&)
+void AudioMixerRenderer::Update(const DurchblickItemConfig& cfg)
 {
     auto h = m_parent->Height() * 0.8;
     auto y = (m_parent->Height() * .2) / 2;
     m_height = h;
     m_y = y;
-    RefreshSliderSizeAndPos();
+
+    // Labels are rasterized at the size they're displayed at, so only a
+    // change of the display scale makes them render their text again
+    if (cfg.scale > 0 && cfg.scale != m_label_scale) {
+        m_label_scale = cfg.scale;
+        for (auto& e : m_entries) {
+            if (e.slider)
+                e.slider->SetLabelScale(m_label_scale);
+        }
+    }
+    Publish();
+}
+
+void AudioMixerRenderer::AccountResources(ResourceUsage& usage)
+{
+    // Only sliders in and around the visible part exist
+    for (auto const& e : m_entries) {
+        if (e.slider)
+            e.slider->AccountResources(usage);
+    }
+    m_labels.AccountResources(usage);
 }
 
 void AudioMixerRenderer::MouseEvent(const LayoutItem::MouseData& e, const DurchblickItemConfig& cfg)
 {
-    for (auto& slider : m_sliders)
-        slider->MouseEvent(e, cfg, m_parent->MouseX(), m_parent->MouseY());
+    if (e.type == QEvent::Wheel) {
+        if (m_parent->Hovered() && e.wheel_delta)
+            ScrollBy(-e.wheel_delta * SlotWidth() / 120);
+        return;
+    }
+
+    for (auto& entry : m_entries) {
+        if (entry.slider)
+            entry.slider->MouseEvent(e, cfg, m_parent->MouseX(), m_parent->MouseY());
+    }
+}
+
+void AudioMixerRenderer::SetChannelWidth(int w)
+{
+    m_channel_width = w;
+    for (auto& e : m_entries) {
+        if (e.slider)
+            e.slider->SetChannelWidth(w);
+    }
+    Publish();
+}
+
+void AudioMixerRenderer::SetDensity(Density d)
+{
+    if (m_density == d)
+        return;
+    // Keep the first visible slider in place
+    const int first = m_scroll / SlotWidth();
+    m_density = d;
+    m_scroll = first * SlotWidth();
+    Publish();
+}
+
+void AudioMixerRenderer::ScrollBy(int pixels)
+{
+    m_scroll += pixels;
+    Publish();
 }
@@ -19,33 +19,37 @@
 #pragma once
 #include "../items/item.hpp"
 #include "callbacks.h"
+#include "label_atlas.hpp"
 #include "volume_meter.hpp"
+#include <QString>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
-class AudioMixerRenderer;
-
 class MixerSlider : public MixerMeter {
+    // The label is replaced on the UI thread and queued on the graphics thread
+    std::mutex m_label_mutex;
     OBSSource m_label {};
-    obs_fader_t* m_fader {};
+    uint64_t m_label_id {};
+    float m_label_font_scale { 1 };
+    float m_label_scale { 1 }; // UI thread
     bool m_dragging_volume { false }, m_lmb_down { false };
     float m_db {}, m_fade { 1 };
-    AudioMixerRenderer* m_parent {};
-    int m_mute_width;
-    int m_mute_height;
 
 protected:
-    void OnSourceNameChanged() override;
-
     void OnSourceVolumeChanged() override
     {
-        SetDb(obs_fader_get_db(m_fader));
+        SetDb(obs_fader_get_db(Fader()));
     }
 
 public:
-    MixerSlider(AudioMixerRenderer*, OBSSource, int x = 10, int y = 10, int height = 100, int channel_width = 3);
-    ~MixerSlider();
+    MixerSlider(OBSSource, int x = 10, int y = 10, int height = 100, int channel_width = 3);
 
-    virtual void Render(float cell_scale, float source_scale_x, float source_scale_y) override;
+    /// Graphics thread, fader, mute button and alarm frame. Drawn after the
+    /// meter batch was flushed, so they stay on top of the meter like before
+    void RenderControls(Geometry const& g, float cell_scale);
 
     void SetHeight(int h) { m_height = h; }
     void SetY(int y) { m_y = y; }
@@ -56,18 +60,25 @@ public:
     }
 
     void SetSource(OBSSource) override;
+    void UpdateLabel();
+
+    /// Scale of the label font, usually the scale the layout is displayed at so the text stays sharp
+    void SetLabelScale(float scale);
 
-    void SetType(obs_fader_type) override;
+    /// Queues the rotated label to the left of the meter
+    void QueueLabel(LabelAtlas& atlas, Geometry const& g);
+    void AccountResources(ResourceUsage& usage);
 
     void SetDb(float db)
     {
         m_db = db;
-        m_fade = obs_fader_get_deflection(m_fader);
+        m_fade = obs_fader_get_deflection(Fader());
     }
 
-    bool MouseOverMuteArea(int x, int y)
+    bool MouseOverMuteArea(int x, int y, float cell_scale)
     {
-        return x >= m_x - 2 && x <= m_x + m_mute_width + 2 && y >= m_y + m_height - m_mute_height - 2 && y <= m_y + m_height + 2;
+        const int mute_height = m_channel_width / cell_scale;
+        return x >= m_x - 2 && x <= m_x + GetWidth() + 2 && y >= m_y + m_height - mute_height - 2 && y <= m_y + m_height + 2;
     }
 
     bool MouseOverSlider(int x, int y)
@@ -84,27 +95,86 @@ public:
 class AudioMixerItem;
 
 class AudioMixerRenderer {
-    std::vector<std::unique_ptr<MixerSlider>> m_sliders;
+public:
+    enum Density {
+        Expanded,
+        Compact
+    };
+
+private:
+    // Mixer order, only touched on the UI thread. Entries outside the visible
+    // window are placeholders without a slider, so they hold no volmeter,
+    // meter lanes or label
+    struct Entry {
+        OBSSource source;
+        std::shared_ptr<MixerSlider> slider;
+        QString sort_key;
+        bool global;
+    };
+    std::vector<Entry> m_entries;
+    std::unordered_set<obs_source_t*> m_members; // Safe as keys, the entries hold a reference
+    // Sources that would be shown if they weren't hidden from the mixer. Keyed by the
+    // weak reference each one holds, so a key can't be reused by a new source
+    std::unordered_map<obs_weak_source_t*, OBSWeakSource> m_hidden;
+
+    // What the render thread draws, built on the UI thread. The geometry is
+    // copied in here, the render thread never reads it from the slider
+    struct View {
+        struct Slot {
+            std::shared_ptr<MixerSlider> slider;
+            MixerMeter::Geometry geometry;
+        };
+        std::vector<Slot> sliders;
+        int scroll {}, content_width {}, view_width {}, bar_y {};
+    };
+
+    // Handed over from the UI thread to the render thread
+    std::mutex m_pending_mutex;
+    View m_pending;
+    bool m_pending_valid { false };
+
+    // Only touched on the render thread
+    View m_view;
+    LabelAtlas m_labels;
+
     int m_height {}, m_y {}, m_channel_width {};
+    int m_scroll {};
+    float m_label_scale { 1 };
+    Density m_density { Expanded };
     AudioMixerItem* m_parent {};
-    bool m_update_queued { false };
-
-    void RefreshSliderSizeAndPos();
+    std::vector<OBSSignal> m_signals;
+
+    static bool EntryLess(Entry const& a, Entry const& b);
+    static void UpdateSortKey(Entry& e);
+    std::vector<Entry>::iterator Find(obs_source_t* src);
+    void Insert(Entry&& e);
+    int SlotWidth() const;
+    int ContentWidth() const;
+    void Publish();
+    void ConnectSignals();
+    static bool IsHidden(obs_source_t* src);
 
 public:
     AudioMixerRenderer(AudioMixerItem* parent, int height = 100, int channel_width = 3);
-    ~AudioMixerRenderer() = default;
+    ~AudioMixerRenderer();
+
+    // UI thread only, each of these only touches the affected slider
+    void EvaluateSource(obs_source_t* src);
+    void AddSource(obs_source_t* src);
+    void RemoveSource(obs_source_t* src);
+    void RenameSource(obs_source_t* src);
+
+    /// UI thread, there is no signal for hiding a source in the OBS mixer, this
+    /// re-reads that setting for the members and the hidden sources
+    void RecheckHidden();
 
-    void UpdateSources();
-    void QueueSourceUpdate() { m_update_queued = true; }
-    void Render(float cell_scale, float source_scale_x, float source_scale_y);
+    void Render(MeterBatch& batch, float cell_scale, float source_scale_x, float source_scale_y);
     void Update(DurchblickItemConfig const& cfg);
+    void AccountResources(ResourceUsage& usage);
 
     void MouseEvent(const LayoutItem::MouseData& e, const DurchblickItemConfig& cfg);
-    void SetChannelWidth(int w)
-    {
-        m_channel_width = w;
-        for (auto& slider : m_sliders)
-            slider->SetChannelWidth(w);
-    }
+    void SetChannelWidth(int w);
+    void SetDensity(Density d);
+    Density GetDensity() const { return m_density; }
+    void ScrollBy(int pixels);
 };
@@ -0,0 +1,269 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "render_profiler.hpp"
+#include "../items/source_item.hpp"
+#include <QApplication>
+#include <algorithm>
+#include <util/platform.h>
+
+#define LABEL_INTERVAL 500000000ull // Text sources rebuild their texture on every change
+#define LABEL_COLOR 0xD91F1F1F
+
+void RenderProfiler::History::Add(float ms)
+{
+    samples[next] = ms;
+    next = (next + 1) % SAMPLES;
+    count = std::min(count + 1, SAMPLES);
+}
+
+void RenderProfiler::History::Summarize(float& avg, float& p99) const
+{
+    avg = p99 = 0;
+    if (count == 0)
+        return;
+
+    float sorted[SAMPLES];
+    std::copy(samples, samples + count, sorted);
+    float sum = 0;
+    for (int i = 0; i < count; i++)
+        sum += sorted[i];
+    avg = sum / count;
+
+    auto* nth = sorted + std::max(0, (count * 99 + 99) / 100 - 1);
+    std::nth_element(sorted, nth, sorted + count);
+    p99 = *nth;
+}
+
+RenderProfiler::~RenderProfiler()
+{
+    obs_enter_graphics();
+    for (auto& f : m_frames) {
+        for (auto* t : f.timers)
+            gs_timer_destroy(t);
+        gs_timer_destroy(f.total);
+        gs_timer_range_destroy(f.range);
+    }
+    obs_leave_graphics();
+}
+
+void RenderProfiler::Resolve(Frame& f)
+{
+    f.pending = false;
+
+    bool disjoint = true;
+    uint64_t frequency = 0;
+    // Not ready after FRAMES frames means the GPU is far behind, this frame is simply lost
+    if (!gs_timer_range_get_data(f.range, &disjoint, &frequency) || disjoint || frequency == 0)
+        return;
+
+    auto ms = [frequency](gs_timer_t* t, float& out) {
+        uint64_t ticks = 0;
+        if (!t || !gs_timer_get_data(t, &ticks))
+            return false;
+        out = float(double(ticks) * 1000.0 / double(frequency));
+        return true;
+    };
+
+    float value;
+    for (auto const& q : f.queries) {
+        auto it = m_entries.find(q.item);
+        if (it != m_entries.end() && ms(q.timer, value))
+            it->second.gpu.Add(value);
+    }
+    if (ms(f.total, value))
+        m_total.gpu.Add(value);
+}
+
+void RenderProfiler::BeginFrame(float label_height)
+{
+    m_frame++;
+    m_current = &m_frames[m_frame % FRAMES];
+    if (m_current->pending)
+        Resolve(*m_current);
+
+    if (!m_current->range)
+        m_current->range = gs_timer_range_create();
+    if (!m_current->total)
+        m_current->total = gs_timer_create();
+    m_current->queries.clear();
+
+    // Labels are made for the canvas size, they're recreated with the next update if it changed
+    if (label_height != m_label_height) {
+        m_label_height = label_height;
+        m_next_label_update = 0;
+    }
+
+    if (m_current->range)
+        gs_timer_range_begin(m_current->range);
+    if (m_current->total)
+        gs_timer_begin(m_current->total);
+    m_frame_start = os_gettime_ns();
+}
+
+void RenderProfiler::BeginItem()
+{
+    auto& f = *m_current;
+    auto index = f.queries.size();
+    if (index == f.timers.size())
+        f.timers.emplace_back(gs_timer_create());
+
+    f.queries.push_back({ nullptr, f.timers[index] });
+    if (f.timers[index])
+        gs_timer_begin(f.timers[index]);
+    m_item_start = os_gettime_ns();
+}
+
+void RenderProfiler::EndItem(LayoutItem const* item)
+{
+    auto elapsed = os_gettime_ns() - m_item_start;
+    auto& q = m_current->queries.back();
+    if (q.timer)
+        gs_timer_end(q.timer);
+    q.item = item;
+
+    auto& e = m_entries[item];
+    e.cpu.Add(elapsed / 1000000.f);
+    e.last_frame = m_frame;
+}
+
+void RenderProfiler::EndFrame()
+{
+    auto elapsed = os_gettime_ns() - m_frame_start;
+    auto& f = *m_current;
+    if (f.total)
+        gs_timer_end(f.total);
+    if (f.range) {
+        gs_timer_range_end(f.range);
+        f.pending = true;
+    }
+    m_total.cpu.Add(elapsed / 1000000.f);
+
+    // Items that didn't render this frame were removed from the layout. A new item can get
+    // the same address, so their queries that are still in flight are dropped as well
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it->second.last_frame != m_frame) {
+            for (auto& frame : m_frames) {
+                for (auto& q : frame.queries) {
+                    if (q.item == it->first)
+                        q.item = nullptr;
+                }
+            }
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    auto now = os_gettime_ns();
+    if (now >= m_next_label_update) {
+        m_next_label_update = now + LABEL_INTERVAL;
+        Texts texts;
+        texts.reserve(m_entries.size());
+        for (auto const& [item, e] : m_entries)
+            texts.emplace_back(item, Text(e, ""));
+        // Creating and updating text sources here would stall rendering
+        QMetaObject::invokeMethod(
+            qApp, [labels = m_labels, texts = std::move(texts), total = Text(m_total, "Total "), height = m_label_height]() {
+                UpdateLabels(*labels, texts, total, height);
+            },
+            Qt::QueuedConnection);
+    }
+}
+
+QString RenderProfiler::Text(Entry const& e, char const* prefix)
+{
+    float cpu_avg, cpu_p99, gpu_avg, gpu_p99;
+    e.cpu.Summarize(cpu_avg, cpu_p99);
+    e.gpu.Summarize(gpu_avg, gpu_p99);
+
+    auto text = QString("%1CPU %2/%3 ms").arg(prefix).arg(cpu_avg, 0, 'f', 2).arg(cpu_p99, 0, 'f', 2);
+    if (e.gpu.count > 0)
+        text += QString("  GPU %1/%2 ms").arg(gpu_avg, 0, 'f', 2).arg(gpu_p99, 0, 'f', 2);
+    return text;
+}
+
+void RenderProfiler::UpdateLabels(Labels& labels, Texts const& texts, QString const& total, float height)
+{
+    // The sources are taken out while they're updated, so the render thread never waits on that
+    std::unordered_map<LayoutItem const*, OBSSource> items;
+    OBSSource total_label;
+    {
+        std::lock_guard<std::mutex> lock(labels.mutex);
+        if (labels.height == height) {
+            items = labels.items;
+            total_label = labels.total;
+        }
+    }
+
+    auto update = [height](OBSSource& label, QString const& text) {
+        if (!label) {
+            label = CreateLabel(qt_to_utf8(text), size_t(height), 1);
+            return;
+        }
+        OBSDataAutoRelease settings = obs_data_create();
+        obs_data_set_string(settings, "text", qt_to_utf8(QString(" %1 ").arg(text)));
+        obs_source_update(label, settings);
+    };
+
+    std::unordered_map<LayoutItem const*, OBSSource> next;
+    for (auto const& [item, text] : texts) {
+        auto& label = next[item];
+        auto it = items.find(item);
+        if (it != items.end())
+            label = it->second;
+        update(label, text);
+    }
+    update(total_label, total);
+
+    std::lock_guard<std::mutex> lock(labels.mutex);
+    labels.items = std::move(next);
+    labels.total = total_label;
+    labels.height = height;
+    // Labels of removed items are released with items, still on the UI thread
+}
+
+void RenderProfiler::DrawLabel(obs_source_t* label, float cx)
+{
+    if (!label)
+        return;
+    auto lw = obs_source_get_width(label);
+    auto lh = obs_source_get_height(label);
+    if (lw == 0 || lh == 0 || cx <= 0)
+        return;
+
+    float scale = std::min(1.f, cx / lw);
+    gs_matrix_push();
+    gs_matrix_scale3f(scale, scale, 1);
+    LayoutItem::DrawBox(lw, lh, LABEL_COLOR);
+    obs_source_video_render(label);
+    gs_matrix_pop();
+}
+
+void RenderProfiler::DrawItem(LayoutItem const* item, float cx)
+{
+    std::lock_guard<std::mutex> lock(m_labels->mutex);
+    auto it = m_labels->items.find(item);
+    if (it != m_labels->items.end())
+        DrawLabel(it->second, cx);
+}
+
+void RenderProfiler::DrawTotal(float cx)
+{
+    std::lock_guard<std::mutex> lock(m_labels->mutex);
+    DrawLabel(m_labels->total, cx);
+}
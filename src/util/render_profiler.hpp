@@ -0,0 +1,106 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#pragma once
+#include <QString>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <obs.hpp>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class LayoutItem;
+
+// Measures how long each item of a layout takes to render, on the CPU
+// and on the GPU. GPU timer queries are recycled from a small pool per
+// frame in flight and read back a few frames later, so the measurement
+// never waits on the GPU. Results are kept as a rolling window per item
+// and shown as average and 99th percentile on top of each cell.
+// Render thread only, the layout only creates one while the overlay is on.
+// The text sources showing the numbers are updated on the UI thread.
+class RenderProfiler {
+    static constexpr int FRAMES = 4;    // Frames in flight before their queries are read back
+    static constexpr int SAMPLES = 128; // Rolling window per item
+
+    struct Query {
+        LayoutItem const* item; // Only used as a key, reset once the item is removed from the layout
+        gs_timer_t* timer;
+    };
+
+    struct Frame {
+        gs_timer_range_t* range {};
+        gs_timer_t* total {};
+        std::vector<gs_timer_t*> timers; // Pool, grows to the number of items in the layout
+        std::vector<Query> queries;
+        bool pending {};
+    };
+
+    struct History {
+        float samples[SAMPLES] {};
+        int count {}, next {};
+
+        void Add(float ms);
+        void Summarize(float& avg, float& p99) const;
+    };
+
+    struct Entry {
+        History cpu, gpu;
+        uint64_t last_frame {};
+    };
+
+    // Shared with queued label updates, which can outlive the profiler
+    struct Labels {
+        std::mutex mutex;
+        std::unordered_map<LayoutItem const*, OBSSource> items;
+        OBSSource total;
+        float height {}; // Canvas height the labels were created for
+    };
+    using Texts = std::vector<std::pair<LayoutItem const*, QString>>;
+
+    Frame m_frames[FRAMES];
+    Frame* m_current {};
+    uint64_t m_frame {}, m_frame_start {}, m_item_start {};
+
+    std::unordered_map<LayoutItem const*, Entry> m_entries;
+    Entry m_total;
+    uint64_t m_next_label_update {};
+    float m_label_height {};
+    std::shared_ptr<Labels> m_labels { std::make_shared<Labels>() };
+
+    void Resolve(Frame& f);
+    static QString Text(Entry const& e, char const* prefix);
+    static void UpdateLabels(Labels& labels, Texts const& texts, QString const& total, float height);
+    static void DrawLabel(obs_source_t* label, float cx);
+
+public:
+    RenderProfiler() = default;
+    ~RenderProfiler();
+
+    /// label_height is the canvas height labels are created for
+    void BeginFrame(float label_height);
+    void BeginItem();
+    void EndItem(LayoutItem const* item);
+    void EndFrame();
+
+    /// Draws the numbers of the item in its own coordinate space, cx is the usable width
+    void DrawItem(LayoutItem const* item, float cx);
+
+    /// Draws the window total at the current origin
+    void DrawTotal(float cx);
+};
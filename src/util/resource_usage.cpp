@@ -0,0 +1,59 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "resource_usage.hpp"
+
+void ResourceUsage::AddLabel(obs_source_t* label)
+{
+    if (!label)
+        return;
+    label_sources++;
+    label_bytes += uint64_t(obs_source_get_width(label)) * obs_source_get_height(label) * 4;
+}
+
+void ResourceUsage::AddMeter(void const* volmeter)
+{
+    meters++;
+    if (volmeter)
+        volmeters.insert(volmeter);
+}
+
+void ResourceUsage::AddTexture(uint32_t cx, uint32_t cy, uint32_t bytes_per_pixel, int count)
+{
+    offscreen_textures += count;
+    offscreen_bytes += uint64_t(cx) * cy * bytes_per_pixel * count;
+}
+
+static QString Size(uint64_t bytes)
+{
+    return QString("%1 MiB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 2);
+}
+
+QString ResourceUsage::Summary() const
+{
+    return QString("%1 items, %2 label sources (%3), %4 meters on %5 volmeters/faders, %6 audio taps, "
+                   "%7 showing references, %8 offscreen textures (%9)")
+        .arg(items)
+        .arg(label_sources)
+        .arg(Size(label_bytes))
+        .arg(meters)
+        .arg(volmeters.size())
+        .arg(audio_taps)
+        .arg(showing_refs)
+        .arg(offscreen_textures)
+        .arg(Size(offscreen_bytes));
+}
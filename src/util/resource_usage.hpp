@@ -0,0 +1,87 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#pragma once
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <obs.hpp>
+#include <unordered_set>
+
+// What a multiview keeps alive: items, private text sources, volmeters,
+// showing references and textures it renders into. Filled in on the UI
+// thread by the window, its layout and every item. Offscreen textures are
+// counted at the size they are used with, not what the driver reports.
+struct ResourceUsage {
+    int items {};
+    int label_sources {};
+    uint64_t label_bytes {}; // Texture memory of the label sources
+    int meters {};           // Volume meter displays
+    int audio_taps {};       // Raw audio capture callbacks
+    int showing_refs {};
+    int offscreen_textures {}; // Render targets, staging surfaces and dynamic textures
+    uint64_t offscreen_bytes {};
+
+    // Meters of the same source share one volmeter and fader, so those are counted once
+    std::unordered_set<void const*> volmeters;
+
+    void AddLabel(obs_source_t* label);
+    void AddMeter(void const* volmeter);
+    void AddTexture(uint32_t cx, uint32_t cy, uint32_t bytes_per_pixel, int count = 1);
+
+    /// One line, used for the log and the multiview dialog
+    QString Summary() const;
+};
+
+// Textures an object allocated, kept up to date by the graphics thread where they
+// are created and read by the UI thread. Everything is freed with the owner
+class TextureTally {
+    std::atomic<int> m_count {};
+    std::atomic<uint64_t> m_bytes {};
+
+public:
+    void Add(uint32_t cx, uint32_t cy, uint32_t bytes_per_pixel)
+    {
+        m_count++;
+        m_bytes += uint64_t(cx) * cy * bytes_per_pixel;
+    }
+
+    void Remove(uint32_t cx, uint32_t cy, uint32_t bytes_per_pixel)
+    {
+        m_count--;
+        m_bytes -= uint64_t(cx) * cy * bytes_per_pixel;
+    }
+
+    /// For render targets that are resized in place, a size of 0 means there was no texture
+    void Resize(uint32_t& cx, uint32_t& cy, uint32_t new_cx, uint32_t new_cy, uint32_t bytes_per_pixel)
+    {
+        if (cx == new_cx && cy == new_cy)
+            return;
+        if (cx && cy)
+            Remove(cx, cy, bytes_per_pixel);
+        if (new_cx && new_cy)
+            Add(new_cx, new_cy, bytes_per_pixel);
+        cx = new_cx;
+        cy = new_cy;
+    }
+
+    void Account(ResourceUsage& usage) const
+    {
+        usage.offscreen_textures += m_count;
+        usage.offscreen_bytes += m_bytes;
+    }
+};
@@ -0,0 +1,81 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Layout of the shared memory segment ShmOutput publishes frames into. This
+// header has no other dependencies so readers outside of OBS can include it,
+// see tools/shm_reader.cpp.
+//
+// Frames are written into a small ring of slots, each slot is guarded by a
+// sequence counter: it's odd while frame n is written and 2 * n + 2 once it's
+// complete. The producer never waits for readers, a reader that was too slow
+// notices the counter changed while it copied and tries the newest frame again.
+namespace ShmFrame {
+
+constexpr uint32_t MAGIC = 0x4b4c4244; // "DBLK"
+constexpr uint32_t VERSION = 1;
+constexpr uint32_t SLOTS = 3;
+
+enum Format : uint32_t {
+    BGRA = 0, // One plane, width * 4 bytes per row
+    NV12 = 1, // Y plane with width bytes per row, followed by the interleaved UV plane at half resolution
+};
+
+struct Slot {
+    std::atomic<uint64_t> seq;
+    uint64_t timestamp; // os_gettime_ns() when the frame was rendered
+    uint64_t offset;    // Start of the frame data from the beginning of the segment
+};
+
+struct Header {
+    // Stored with release once everything else is set, readers load it with acquire first
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    uint32_t format;
+    uint32_t width, height;
+    uint32_t frame_size; // Bytes per frame, planes are tightly packed
+    // Set once the producer stopped or changed the resolution, readers have to open the segment again
+    std::atomic<uint32_t> closed;
+    // Number of published frames, the newest one is in slot (frames - 1) % SLOTS
+    std::atomic<uint64_t> frames;
+    Slot slots[SLOTS];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared memory counters have to be lock free");
+
+inline size_t Align(size_t n)
+{
+    return (n + 63) & ~size_t(63);
+}
+
+inline uint32_t FrameSize(uint32_t format, uint32_t width, uint32_t height)
+{
+    if (format == NV12)
+        return width * height + width * (height / 2);
+    return width * height * 4;
+}
+
+inline size_t SegmentSize(uint32_t frame_size)
+{
+    return Align(sizeof(Header)) + SLOTS * Align(frame_size);
+}
+
+}
@@ -0,0 +1,312 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "shm_output.hpp"
+#include "util.h"
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <util/util.hpp>
+
+#ifndef _WIN32
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <unistd.h>
+#endif
+
+static struct {
+    gs_effect_t* effect {};
+    gs_eparam_t* image {};
+} nv12_effect = {};
+
+void ShmOutput::Init()
+{
+    BPtr<char> effect_path = obs_module_file("nv12.effect");
+    char* errors = nullptr;
+
+    obs_enter_graphics();
+    nv12_effect.effect = gs_effect_create_from_file(effect_path, &errors);
+    if (nv12_effect.effect)
+        nv12_effect.image = gs_effect_get_param_by_name(nv12_effect.effect, "image");
+    else
+        berr("Failed to load NV12 conversion effect from '%s': %s", effect_path.Get(), errors ? errors : "unknown error");
+    obs_leave_graphics();
+    bfree(errors);
+}
+
+void ShmOutput::Deinit()
+{
+    obs_enter_graphics();
+    gs_effect_destroy(nv12_effect.effect);
+    obs_leave_graphics();
+    nv12_effect = {};
+}
+
+ShmOutput::ShmOutput()
+{
+    // A single worker keeps the frames in order and is the only one touching the segment
+    m_workers.setMaxThreadCount(1);
+}
+
+ShmOutput::~ShmOutput()
+{
+    m_enabled = false;
+    m_workers.waitForDone();
+    CloseSegment();
+
+    obs_enter_graphics();
+    gs_texrender_destroy(m_luma);
+    gs_texrender_destroy(m_chroma);
+    obs_leave_graphics();
+
+    if (m_dropped > 0)
+        binfo("Shared memory output dropped %llu frames", (unsigned long long)m_dropped.load());
+}
+
+void ShmOutput::SetOutput(QString const& name, ShmFrame::Format format, bool enabled)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_config_mutex);
+        m_name = name.startsWith('/') ? name : "/" + name;
+        m_format = format;
+    }
+    m_enabled = enabled;
+
+    // Frames that are still in flight notice that the output is off and skip the write
+    if (!enabled)
+        m_workers.start([this]() { CloseSegment(); });
+}
+
+bool ShmOutput::BeginCapture(uint32_t cx, uint32_t cy)
+{
+    if (!m_enabled || cx < 2 || cy < 2)
+        return false;
+
+    ShmFrame::Format format;
+    {
+        std::lock_guard<std::mutex> lock(m_config_mutex);
+        format = m_format;
+    }
+    if (format == ShmFrame::NV12) {
+        if (!nv12_effect.effect)
+            return false;
+        // Chroma is subsampled by two in both directions
+        cx &= ~1u;
+        cy &= ~1u;
+    }
+
+    m_capture = m_ring.Acquire(cx, cy, format == ShmFrame::NV12 ? StagingRing::Planes::NV12 : StagingRing::Planes::BGRA);
+    if (!m_capture) {
+        m_dropped++;
+        return false;
+    }
+    if (!m_ring.BeginRender(cx, cy, cx, cy)) {
+        m_capture = nullptr;
+        return false;
+    }
+    return true;
+}
+
+static bool ConvertPlane(gs_texrender_t* target, gs_texture_t* tex, char const* technique, uint32_t cx, uint32_t cy)
+{
+    gs_texrender_reset(target);
+    if (!gs_texrender_begin(target, cx, cy))
+        return false;
+    gs_ortho(0.0f, float(cx), 0.0f, float(cy), -100.0f, 100.0f);
+    gs_effect_set_texture(nv12_effect.image, tex);
+    while (gs_effect_loop(nv12_effect.effect, technique))
+        gs_draw_sprite(tex, 0, cx, cy);
+    gs_texrender_end(target);
+    return true;
+}
+
+void ShmOutput::EndCapture()
+{
+    if (!m_capture)
+        return;
+    gs_texture_t* tex = m_ring.EndRender();
+
+    gs_blend_state_push();
+    gs_enable_blending(false);
+
+    if (m_capture->planes == StagingRing::Planes::NV12) {
+        if (!m_luma)
+            m_luma = gs_texrender_create(GS_R8, GS_ZS_NONE);
+        if (!m_chroma)
+            m_chroma = gs_texrender_create(GS_R8G8, GS_ZS_NONE);
+
+        // The frame is dropped if the conversion fails
+        if (ConvertPlane(m_luma, tex, "Luma", m_capture->cx, m_capture->cy)
+            && ConvertPlane(m_chroma, tex, "Chroma", m_capture->cx / 2, m_capture->cy / 2)) {
+            m_textures.Resize(m_luma_cx, m_luma_cy, m_capture->cx, m_capture->cy, 1);
+            m_textures.Resize(m_chroma_cx, m_chroma_cy, m_capture->cx / 2, m_capture->cy / 2, 2);
+            m_ring.Stage(m_capture, gs_texrender_get_texture(m_luma), gs_texrender_get_texture(m_chroma));
+        }
+    } else {
+        m_ring.Stage(m_capture, tex);
+    }
+    m_capture = nullptr;
+
+    // Show the frame on the display as well
+    gs_effect_t* effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+    gs_eparam_t* image = gs_effect_get_param_by_name(effect, "image");
+    gs_effect_set_texture(image, tex);
+    while (gs_effect_loop(effect, "Draw"))
+        gs_draw_sprite(tex, 0, gs_texture_get_width(tex), gs_texture_get_height(tex));
+    gs_blend_state_pop();
+}
+
+void ShmOutput::Poll()
+{
+    m_ring.Poll([this](StagingRing::Slot& slot) {
+        auto* s = &slot;
+        m_workers.start([this, s]() { Write(s); });
+        return true;
+    });
+}
+
+void ShmOutput::Write(StagingRing::Slot* slot)
+{
+    const ShmFrame::Format format = slot->planes == StagingRing::Planes::NV12 ? ShmFrame::NV12 : ShmFrame::BGRA;
+    uint8_t const* const* planes = slot->data;
+    uint32_t const* linesizes = slot->linesize;
+
+    QString name;
+    {
+        std::lock_guard<std::mutex> lock(m_config_mutex);
+        name = m_name;
+    }
+
+    if (!m_enabled || !OpenSegment(name, format, slot->cx, slot->cy)) {
+        slot->Release();
+        return;
+    }
+
+    auto* header = reinterpret_cast<ShmFrame::Header*>(m_map);
+    uint64_t n = header->frames.load(std::memory_order_relaxed);
+    auto& target = header->slots[n % ShmFrame::SLOTS];
+
+    target.seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint8_t* dst = m_map + target.offset;
+    if (format == ShmFrame::NV12) {
+        for (uint32_t y = 0; y < slot->cy; y++, dst += slot->cx)
+            memcpy(dst, planes[0] + size_t(y) * linesizes[0], slot->cx);
+        for (uint32_t y = 0; y < slot->cy / 2; y++, dst += slot->cx)
+            memcpy(dst, planes[1] + size_t(y) * linesizes[1], slot->cx);
+    } else {
+        const size_t row = size_t(slot->cx) * 4;
+        if (linesizes[0] == row) {
+            memcpy(dst, planes[0], row * slot->cy);
+        } else {
+            for (uint32_t y = 0; y < slot->cy; y++, dst += row)
+                memcpy(dst, planes[0] + size_t(y) * linesizes[0], row);
+        }
+    }
+    target.timestamp = slot->timestamp;
+    // The surfaces can go back to the render thread, the segment is ours until the next job
+    slot->Release();
+
+    target.seq.store(2 * n + 2, std::memory_order_release);
+    header->frames.store(n + 1, std::memory_order_release);
+}
+
+#ifndef _WIN32
+bool ShmOutput::OpenSegment(QString const& name, uint32_t format, uint32_t cx, uint32_t cy)
+{
+    if (m_map) {
+        auto* header = reinterpret_cast<ShmFrame::Header*>(m_map);
+        if (name == m_segment_name && header->format == format && header->width == cx && header->height == cy)
+            return true;
+        // Readers can't follow a resize of the mapping, they have to open the new segment
+        CloseSegment();
+    }
+
+    auto utf8 = name.toUtf8();
+    const uint32_t frame_size = ShmFrame::FrameSize(format, cx, cy);
+    const size_t size = ShmFrame::SegmentSize(frame_size);
+
+    shm_unlink(utf8.constData());
+    m_fd = shm_open(utf8.constData(), O_CREAT | O_RDWR, 0644);
+    if (m_fd < 0) {
+        berr("Couldn't create shared memory segment '%s': %s", utf8.constData(), strerror(errno));
+        return false;
+    }
+    if (ftruncate(m_fd, off_t(size)) != 0) {
+        berr("Couldn't resize shared memory segment '%s' to %zu bytes: %s", utf8.constData(), size, strerror(errno));
+        close(m_fd);
+        m_fd = -1;
+        shm_unlink(utf8.constData());
+        return false;
+    }
+
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (map == MAP_FAILED) {
+        berr("Couldn't map shared memory segment '%s': %s", utf8.constData(), strerror(errno));
+        close(m_fd);
+        m_fd = -1;
+        shm_unlink(utf8.constData());
+        return false;
+    }
+    m_map = static_cast<uint8_t*>(map);
+    m_map_size = size;
+    m_segment_name = name;
+
+    auto* header = new (m_map) ShmFrame::Header {};
+    header->version = ShmFrame::VERSION;
+    header->format = format;
+    header->width = cx;
+    header->height = cy;
+    header->frame_size = frame_size;
+    for (uint32_t i = 0; i < ShmFrame::SLOTS; i++)
+        header->slots[i].offset = ShmFrame::Align(sizeof(ShmFrame::Header)) + i * ShmFrame::Align(frame_size);
+    // Readers check the magic first, so they never see a half initialized header
+    header->magic.store(ShmFrame::MAGIC, std::memory_order_release);
+
+    binfo("Publishing %ux%u %s frames to shared memory segment '%s'", cx, cy,
+        format == ShmFrame::NV12 ? "NV12" : "BGRA", utf8.constData());
+    return true;
+}
+
+void ShmOutput::CloseSegment()
+{
+    if (!m_map)
+        return;
+    reinterpret_cast<ShmFrame::Header*>(m_map)->closed.store(1, std::memory_order_release);
+    munmap(m_map, m_map_size);
+    close(m_fd);
+    shm_unlink(qt_to_utf8(m_segment_name));
+    m_map = nullptr;
+    m_map_size = 0;
+    m_fd = -1;
+    m_segment_name.clear();
+}
+#else
+bool ShmOutput::OpenSegment(QString const&, uint32_t, uint32_t, uint32_t)
+{
+    static bool warned = false;
+    if (!warned)
+        bwarn("The shared memory output is only available on Linux and macOS");
+    warned = true;
+    return false;
+}
+
+void ShmOutput::CloseSegment()
+{
+}
+#endif
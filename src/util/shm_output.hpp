@@ -0,0 +1,84 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#pragma once
+#include "resource_usage.hpp"
+#include "shm_frame.hpp"
+#include "staging_ring.hpp"
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+#include <mutex>
+#include <obs-module.h>
+
+// Publishes every frame a display draws into a shared memory segment (see
+// shm_frame.hpp), so other processes on this machine can read the multiview
+// without capturing its window. The frame is rendered into a texture, converted
+// to NV12 on the GPU if needed and read back through a StagingRing. Copying
+// into the segment happens on a worker
+// thread. Frames are dropped if the worker or the GPU falls behind, the render
+// thread never waits for either and nothing waits for readers.
+class ShmOutput {
+    // Graphics thread only
+    StagingRing m_ring;
+    gs_texrender_t *m_luma {}, *m_chroma {};
+    uint32_t m_luma_cx {}, m_luma_cy {}, m_chroma_cx {}, m_chroma_cy {};
+    StagingRing::Slot* m_capture {};
+    TextureTally m_textures; // NV12 conversion targets
+
+    std::atomic<bool> m_enabled { false };
+    std::atomic<uint64_t> m_dropped {};
+
+    std::mutex m_config_mutex;
+    QString m_name;
+    ShmFrame::Format m_format { ShmFrame::BGRA };
+
+    // Worker thread only
+    QThreadPool m_workers;
+    QString m_segment_name;
+    int m_fd { -1 };
+    uint8_t* m_map {};
+    size_t m_map_size {};
+
+    void Write(StagingRing::Slot* slot);
+    bool OpenSegment(QString const& name, uint32_t format, uint32_t cx, uint32_t cy);
+    void CloseSegment();
+
+public:
+    ShmOutput();
+    ~ShmOutput();
+
+    static void Init();
+    static void Deinit();
+
+    /// UI thread. name is the POSIX shared memory name, a leading slash is added if missing
+    void SetOutput(QString const& name, ShmFrame::Format format, bool enabled);
+
+    /// Graphics thread. Returns true if this frame is published, in that case the
+    /// display has to be drawn between BeginCapture() and EndCapture()
+    bool BeginCapture(uint32_t cx, uint32_t cy);
+    void EndCapture();
+
+    /// Graphics thread, once per frame
+    void Poll();
+
+    void AccountResources(ResourceUsage& usage) const
+    {
+        m_ring.AccountResources(usage);
+        m_textures.Account(usage);
+    }
+};
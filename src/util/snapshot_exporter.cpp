@@ -0,0 +1,122 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "snapshot_exporter.hpp"
+#include "util.h"
+#include <QDir>
+#include <QImage>
+#include <util/util.hpp>
+
+SnapshotExporter::SnapshotExporter()
+{
+    // One worker keeps the files in order and bounds the memory held by pending images
+    m_workers.setMaxThreadCount(1);
+}
+
+SnapshotExporter::~SnapshotExporter()
+{
+    m_workers.waitForDone();
+
+    if (m_dropped > 0)
+        binfo("%llu snapshots were dropped because all staging surfaces were busy", (unsigned long long)m_dropped.load());
+}
+
+void SnapshotExporter::SetOutput(QString const& directory, QString const& prefix, QString const& format)
+{
+    std::lock_guard<std::mutex> lock(m_output_mutex);
+    m_directory = directory;
+    m_prefix = prefix;
+    m_format = format == "jpg" ? "jpg" : "png";
+}
+
+bool SnapshotExporter::BeginCapture(uint32_t cx, uint32_t cy)
+{
+    if (!m_requested.exchange(false) || cx == 0 || cy == 0)
+        return false;
+
+    m_capture = m_ring.Acquire(cx, cy);
+    if (!m_capture) {
+        // Never wait for the GPU or the worker, the next request will go through
+        m_dropped++;
+        return false;
+    }
+    if (!m_ring.BeginRender(cx, cy, cx, cy)) {
+        m_capture = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void SnapshotExporter::EndCapture()
+{
+    if (!m_capture)
+        return;
+    gs_texture_t* tex = m_ring.EndRender();
+    m_ring.Stage(m_capture, tex);
+    m_times[m_ring.Index(*m_capture)] = QDateTime::currentDateTime();
+    m_capture = nullptr;
+
+    // The frame went into the texture, so it still has to reach the display
+    gs_blend_state_push();
+    gs_enable_blending(false);
+    gs_effect_t* effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+    gs_eparam_t* image = gs_effect_get_param_by_name(effect, "image");
+    gs_effect_set_texture(image, tex);
+    while (gs_effect_loop(effect, "Draw"))
+        gs_draw_sprite(tex, 0, gs_texture_get_width(tex), gs_texture_get_height(tex));
+    gs_blend_state_pop();
+}
+
+void SnapshotExporter::Poll()
+{
+    // The surface stays mapped until the worker copied the pixels out
+    m_ring.Poll([this](StagingRing::Slot& slot) {
+        auto* s = &slot;
+        auto time = m_times[m_ring.Index(slot)];
+        m_workers.start([this, s, time]() { Encode(s, time); });
+        return true;
+    });
+}
+
+void SnapshotExporter::Encode(StagingRing::Slot* slot, QDateTime const& time)
+{
+    // BGRA in memory is what QImage calls (A)RGB32 on little endian machines
+    auto image = QImage(slot->data[0], int(slot->cx), int(slot->cy), int(slot->linesize[0]), QImage::Format_RGB32).copy();
+    slot->Release();
+
+    QString directory, prefix, format;
+    {
+        std::lock_guard<std::mutex> lock(m_output_mutex);
+        directory = m_directory;
+        prefix = m_prefix;
+        format = m_format;
+    }
+    if (directory.isEmpty()) {
+        BPtr<char> path = obs_module_config_path("snapshots");
+        directory = utf8_to_qt(path.Get());
+    }
+
+    QDir dir(directory);
+    if (!dir.mkpath(".")) {
+        bwarn("Couldn't create snapshot directory '%s'", qt_to_utf8(directory));
+        return;
+    }
+
+    auto file = dir.filePath(QString("%1_%2.%3").arg(prefix.isEmpty() ? "multiview" : prefix, time.toString("yyyy-MM-dd_HH-mm-ss-zzz"), format));
+    if (!image.save(file, format == "jpg" ? "JPG" : "PNG", format == "jpg" ? 90 : -1))
+        bwarn("Couldn't write snapshot to '%s'", qt_to_utf8(file));
+}
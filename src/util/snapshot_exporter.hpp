@@ -0,0 +1,68 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#pragma once
+#include "resource_usage.hpp"
+#include "staging_ring.hpp"
+#include <QDateTime>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+#include <mutex>
+#include <obs-module.h>
+
+// Takes stills of whatever a display draws without stalling the GPU. On a
+// frame with a pending request the display is rendered into a texture and read
+// back through a StagingRing. Reading the pixels, encoding and writing the file
+// happen on a worker thread. If all surfaces are still busy the request is
+// dropped instead of waiting.
+class SnapshotExporter {
+    // Graphics thread only
+    StagingRing m_ring;
+    StagingRing::Slot* m_capture {}; // Slot the current frame is captured into
+    QDateTime m_times[StagingRing::SIZE]; // When the frame in each slot was taken
+
+    std::atomic<bool> m_requested { false };
+    std::atomic<uint64_t> m_dropped {};
+
+    std::mutex m_output_mutex;
+    QString m_directory, m_prefix, m_format { "png" };
+
+    QThreadPool m_workers;
+
+    void Encode(StagingRing::Slot* slot, QDateTime const& time);
+
+public:
+    SnapshotExporter();
+    ~SnapshotExporter();
+
+    /// Any thread, the snapshot is taken on the next rendered frame
+    void Request() { m_requested = true; }
+
+    void AccountResources(ResourceUsage& usage) const { m_ring.AccountResources(usage); }
+
+    /// UI thread. format is "png" or "jpg", files are named <prefix>_<time>.<format>
+    void SetOutput(QString const& directory, QString const& prefix, QString const& format);
+
+    /// Graphics thread. Returns true if this frame should be captured, in that case the
+    /// display has to be drawn between BeginCapture() and EndCapture()
+    bool BeginCapture(uint32_t cx, uint32_t cy);
+    void EndCapture();
+
+    /// Graphics thread, once per frame. Maps finished copies and releases read surfaces
+    void Poll();
+};
@@ -0,0 +1,117 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "spectrum_analyzer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <graphics/math-defs.h>
+
+// How fast a band falls back after a peak
+#define RELEASE_DB_PER_SECOND 24.f
+
+static SpectrumAnalyzer::Bands Silence()
+{
+    SpectrumAnalyzer::Bands bands;
+    bands.fill(SpectrumAnalyzer::FLOOR);
+    return bands;
+}
+
+SpectrumAnalyzer::SpectrumAnalyzer()
+    : m_bands(Silence())
+{
+    m_window.resize(FFT_SIZE);
+    m_history.resize(2 * FFT_SIZE);
+    m_power.resize(m_fft.Bins());
+
+    // Hann window
+    double sum = 0;
+    for (uint32_t i = 0; i < FFT_SIZE; i++) {
+        m_window[i] = float(0.5 - 0.5 * cos(2 * M_PI * i / FFT_SIZE));
+        sum += m_window[i];
+    }
+    m_scale = float(4.0 / (sum * sum));
+
+    std::fill(std::begin(m_smoothed), std::end(m_smoothed), FLOOR);
+}
+
+void SpectrumAnalyzer::Reset(uint32_t channels, uint32_t sample_rate, speaker_layout)
+{
+    m_channels = channels;
+    m_sample_rate = std::max<uint32_t>(sample_rate, 1);
+    m_history_pos = 0;
+    m_since_hop = 0;
+    std::fill(m_history.begin(), m_history.end(), 0.f);
+    std::fill(std::begin(m_smoothed), std::end(m_smoothed), FLOOR);
+
+    // Band edges are spaced evenly on a log scale, bands narrower than a bin use the closest one
+    const float bin_width = float(m_sample_rate) / FFT_SIZE;
+    const float high = std::min(20000.f, m_sample_rate / 2.f);
+    const uint32_t last_bin = m_fft.Bins() - 1;
+    m_high_frequency = high;
+    for (int b = 0; b < BANDS; b++) {
+        float lo = LOW_FREQUENCY * powf(high / LOW_FREQUENCY, float(b) / BANDS);
+        float hi = LOW_FREQUENCY * powf(high / LOW_FREQUENCY, float(b + 1) / BANDS);
+        int first = int(ceilf(lo / bin_width));
+        int last = int(floorf(hi / bin_width));
+        if (last < first)
+            first = last = int(lroundf(sqrtf(lo * hi) / bin_width));
+        m_band_first[b] = std::clamp<uint32_t>(first, 1, last_bin);
+        m_band_last[b] = std::clamp<uint32_t>(last, m_band_first[b], last_bin);
+    }
+
+    m_bands.Back().fill(FLOOR);
+    m_bands.Publish();
+}
+
+void SpectrumAnalyzer::Process(float const* samples, uint32_t frames)
+{
+    if (!m_channels)
+        return;
+
+    const uint32_t hop = std::max<uint32_t>(1, uint32_t(uint64_t(m_sample_rate) * m_hop_ms / 1000));
+    const float gain = 1.f / m_channels;
+    for (uint32_t f = 0; f < frames; f++, samples += m_channels) {
+        float sum = 0;
+        for (uint32_t c = 0; c < m_channels; c++)
+            sum += samples[c];
+        // Written twice, so the last FFT_SIZE samples are always contiguous
+        m_history[m_history_pos] = m_history[m_history_pos + FFT_SIZE] = sum * gain;
+        m_history_pos = (m_history_pos + 1) % FFT_SIZE;
+
+        if (++m_since_hop >= hop) {
+            m_since_hop = 0;
+            Analyze();
+        }
+    }
+}
+
+void SpectrumAnalyzer::Analyze()
+{
+    m_fft.Power(m_history.data() + m_history_pos, m_window.data(), m_power.data());
+
+    const float release = RELEASE_DB_PER_SECOND * m_hop_ms / 1000.f;
+    auto& out = m_bands.Back();
+    for (int b = 0; b < BANDS; b++) {
+        float power = 0;
+        for (uint32_t k = m_band_first[b]; k <= m_band_last[b]; k++)
+            power = std::max(power, m_power[k]);
+        float db = power > 0 ? std::max(10.f * log10f(power * m_scale), FLOOR) : FLOOR;
+        m_smoothed[b] = std::max(db, m_smoothed[b] - release);
+        out[b] = m_smoothed[b];
+    }
+    m_bands.Publish();
+}
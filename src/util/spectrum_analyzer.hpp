@@ -0,0 +1,68 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#pragma once
+#include "audio_tap.hpp"
+#include "fft.hpp"
+#include "triple_buffer.hpp"
+#include <array>
+#include <atomic>
+#include <vector>
+
+// Real time analyzer on the worker of an AudioTap. Every hop the last
+// FFT_SIZE samples of the channel average are transformed and folded into
+// logarithmically spaced bands, which fall back slowly after a peak. Results
+// go through a triple buffer, so the render thread always reads a complete
+// analysis without ever waiting for the worker.
+class SpectrumAnalyzer : public AudioConsumer {
+public:
+    static constexpr uint32_t FFT_SIZE = 4096;
+    static constexpr int BANDS = 64;
+    static constexpr float LOW_FREQUENCY = 20.f;
+    static constexpr float FLOOR = -90.f; // dBFS
+
+    using Bands = std::array<float, BANDS>;
+
+private:
+    Fft m_fft { FFT_SIZE };
+    std::vector<float> m_window, m_history, m_power;
+    float m_scale {}; // Makes a full scale sine read 0 dBFS
+    uint32_t m_channels {}, m_sample_rate {}, m_history_pos {}, m_since_hop {};
+    uint32_t m_band_first[BANDS] {}, m_band_last[BANDS] {};
+    float m_smoothed[BANDS] {};
+    std::atomic<int> m_hop_ms { 20 };
+    std::atomic<float> m_high_frequency { 20000.f };
+    TripleBuffer<Bands> m_bands;
+
+    void Analyze();
+
+public:
+    SpectrumAnalyzer();
+
+    void Reset(uint32_t channels, uint32_t sample_rate, speaker_layout speakers) override;
+    void Process(float const* samples, uint32_t frames) override;
+
+    /// Any thread, time between two analyses in milliseconds
+    void SetHop(int ms) { m_hop_ms = ms; }
+    int Hop() const { return m_hop_ms; }
+
+    /// Any thread, upper end of the last band
+    float HighFrequency() const { return m_high_frequency; }
+
+    /// Render thread only, levels in dBFS from low to high
+    Bands const& Read() { return m_bands.Front(); }
+};
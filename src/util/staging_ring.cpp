@@ -0,0 +1,178 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "staging_ring.hpp"
+#include "util.h"
+#include <util/platform.h>
+
+StagingRing::~StagingRing()
+{
+    obs_enter_graphics();
+    for (auto& slot : m_slots) {
+        if (slot.state == Slot::State::Mapped)
+            Unmap(slot);
+        for (auto* surface : slot.surfaces)
+            gs_stagesurface_destroy(surface);
+    }
+    gs_texrender_destroy(m_texrender);
+    obs_leave_graphics();
+}
+
+void StagingRing::Allocate(Slot& slot, uint32_t cx, uint32_t cy, Planes planes)
+{
+    if (slot.surfaces[0]) {
+        // Luma and chroma together take 1.5 bytes per pixel
+        if (slot.planes == Planes::NV12)
+            m_textures.Remove(slot.cx, slot.cy, 1);
+        else
+            m_textures.Remove(slot.cx, slot.cy, 4);
+    }
+    if (slot.surfaces[1])
+        m_textures.Remove(slot.cx / 2, slot.cy / 2, 2);
+    for (auto*& surface : slot.surfaces) {
+        gs_stagesurface_destroy(surface);
+        surface = nullptr;
+    }
+
+    if (planes == Planes::NV12) {
+        slot.surfaces[0] = gs_stagesurface_create(cx, cy, GS_R8);
+        slot.surfaces[1] = gs_stagesurface_create(cx / 2, cy / 2, GS_R8G8);
+        if (slot.surfaces[0])
+            m_textures.Add(cx, cy, 1);
+        if (slot.surfaces[1])
+            m_textures.Add(cx / 2, cy / 2, 2);
+    } else {
+        slot.surfaces[0] = gs_stagesurface_create(cx, cy, GS_BGRA);
+        if (slot.surfaces[0])
+            m_textures.Add(cx, cy, 4);
+    }
+    slot.cx = cx;
+    slot.cy = cy;
+    slot.planes = planes;
+}
+
+StagingRing::Slot* StagingRing::Acquire(uint32_t cx, uint32_t cy, Planes planes)
+{
+    Slot* reusable = nullptr;
+    for (auto& slot : m_slots) {
+        if (slot.state != Slot::State::Free)
+            continue;
+        if (slot.surfaces[0] && slot.cx == cx && slot.cy == cy && slot.planes == planes)
+            return &slot;
+        if (!reusable)
+            reusable = &slot;
+    }
+    if (!reusable)
+        return nullptr;
+
+    // The size changed (or this is the first capture)
+    Allocate(*reusable, cx, cy, planes);
+    if (!reusable->surfaces[0] || (planes == Planes::NV12 && !reusable->surfaces[1])) {
+        berr("Failed to create %ux%u staging surfaces", cx, cy);
+        return nullptr;
+    }
+    return reusable;
+}
+
+bool StagingRing::BeginRender(uint32_t cx, uint32_t cy, uint32_t content_cx, uint32_t content_cy)
+{
+    if (!m_texrender)
+        m_texrender = gs_texrender_create(GS_BGRA, GS_ZS_NONE);
+    gs_texrender_reset(m_texrender);
+    if (!gs_texrender_begin(m_texrender, cx, cy))
+        return false;
+    m_textures.Resize(m_render_cx, m_render_cy, cx, cy, 4);
+
+    vec4 clear_color;
+    vec4_set(&clear_color, 0.0f, 0.0f, 0.0f, 1.0f);
+    gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
+    gs_ortho(0.0f, float(content_cx), 0.0f, float(content_cy), -100.0f, 100.0f);
+    gs_matrix_push();
+    gs_matrix_identity();
+    gs_blend_state_push();
+    gs_reset_blend_state();
+    return true;
+}
+
+gs_texture_t* StagingRing::EndRender()
+{
+    gs_blend_state_pop();
+    gs_matrix_pop();
+    gs_texrender_end(m_texrender);
+    return gs_texrender_get_texture(m_texrender);
+}
+
+void StagingRing::Stage(Slot* slot, gs_texture_t* plane, gs_texture_t* second_plane)
+{
+    gs_stage_texture(slot->surfaces[0], plane);
+    if (slot->surfaces[1] && second_plane)
+        gs_stage_texture(slot->surfaces[1], second_plane);
+    slot->state = Slot::State::Staged;
+    slot->staged_poll = m_polls;
+    slot->timestamp = os_gettime_ns();
+}
+
+bool StagingRing::Map(Slot& slot)
+{
+    const int count = slot.planes == Planes::NV12 ? 2 : 1;
+    int mapped = 0;
+    while (mapped < count && gs_stagesurface_map(slot.surfaces[mapped], &slot.data[mapped], &slot.linesize[mapped]))
+        mapped++;
+    if (mapped == count)
+        return true;
+    while (mapped > 0)
+        gs_stagesurface_unmap(slot.surfaces[--mapped]);
+    return false;
+}
+
+void StagingRing::Unmap(Slot& slot)
+{
+    const int count = slot.planes == Planes::NV12 ? 2 : 1;
+    for (int i = 0; i < count; i++) {
+        gs_stagesurface_unmap(slot.surfaces[i]);
+        slot.data[i] = nullptr;
+        slot.linesize[i] = 0;
+    }
+    slot.state = Slot::State::Free;
+}
+
+void StagingRing::Poll(std::function<bool(Slot&)> const& on_mapped)
+{
+    m_polls++;
+    for (auto& slot : m_slots) {
+        if (slot.state == Slot::State::Staged && m_polls - slot.staged_poll >= MAP_DELAY) {
+            if (!Map(slot)) {
+                slot.state = Slot::State::Free;
+                continue;
+            }
+            slot.state = Slot::State::Mapped;
+            slot.released = false;
+            if (!on_mapped(slot))
+                Unmap(slot);
+        } else if (slot.state == Slot::State::Mapped && slot.released) {
+            Unmap(slot);
+        }
+    }
+}
+
+void StagingRing::Discard()
+{
+    for (auto& slot : m_slots) {
+        if (slot.state == Slot::State::Staged)
+            slot.state = Slot::State::Free;
+    }
+}
@@ -0,0 +1,103 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#pragma once
+#include "resource_usage.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <obs-module.h>
+
+// Reads rendered frames back to the CPU without stalling the GPU. Whatever is
+// drawn between BeginRender() and EndRender() lands in a texture, which is
+// copied into one of a few staging surfaces and only mapped a couple of polls
+// later, once the copy is done. A mapping can be handed to a worker, the
+// surface is reused once the worker released it. If every surface is busy the
+// caller skips the frame instead of waiting. Graphics thread only, except for
+// Slot::Release().
+class StagingRing {
+public:
+    static constexpr int SIZE = 3;
+    static constexpr uint64_t MAP_DELAY = 2; // Polls between staging and mapping a surface
+
+    enum class Planes {
+        BGRA,
+        NV12, // Full size R8 luma and half size R8G8 chroma
+    };
+
+    struct Slot {
+        gs_stagesurf_t* surfaces[2] {};
+        Planes planes { Planes::BGRA };
+        uint32_t cx {}, cy {};
+        uint64_t timestamp {}; // os_gettime_ns() when the frame was staged
+
+        // Only valid while the slot is mapped
+        uint8_t* data[2] {};
+        uint32_t linesize[2] {};
+
+        /// Any thread, hands a mapping that was kept for a worker back to the ring
+        void Release() { released = true; }
+
+    private:
+        friend class StagingRing;
+        enum class State {
+            Free,
+            Staged, // Copy queued on the GPU
+            Mapped,
+        } state { State::Free };
+        uint64_t staged_poll {};
+        std::atomic<bool> released { false };
+    };
+
+private:
+    Slot m_slots[SIZE];
+    gs_texrender_t* m_texrender {};
+    uint32_t m_render_cx {}, m_render_cy {};
+    uint64_t m_polls {};
+    TextureTally m_textures;
+
+    void Allocate(Slot& slot, uint32_t cx, uint32_t cy, Planes planes);
+    bool Map(Slot& slot);
+    void Unmap(Slot& slot);
+
+public:
+    StagingRing() = default;
+    ~StagingRing();
+
+    /// Free slot with surfaces of the given size, nullptr if all of them are busy
+    Slot* Acquire(uint32_t cx, uint32_t cy, Planes planes = Planes::BGRA);
+
+    /// Starts drawing into a cx x cy BGRA texture cleared to black. Whatever is drawn
+    /// for a content_cx x content_cy target is scaled to fit. Blend state and matrix
+    /// are reset until EndRender(), which returns the texture
+    bool BeginRender(uint32_t cx, uint32_t cy, uint32_t content_cx, uint32_t content_cy);
+    gs_texture_t* EndRender();
+
+    /// Queues the copy of one texture per plane into the slot
+    void Stage(Slot* slot, gs_texture_t* plane, gs_texture_t* second_plane = nullptr);
+
+    /// Once per frame. Calls on_mapped for every slot whose copy is done, if it returns
+    /// true the slot stays mapped until Slot::Release(), otherwise it's unmapped right away
+    void Poll(std::function<bool(Slot&)> const& on_mapped);
+
+    /// Forgets copies that are staged but not mapped yet
+    void Discard();
+
+    int Index(Slot const& slot) const { return int(&slot - m_slots); }
+
+    void AccountResources(ResourceUsage& usage) const { m_textures.Account(usage); }
+};
@@ -0,0 +1,51 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#pragma once
+#include <atomic>
+
+// Hands the latest value from one writer thread to one reader thread without
+// either of them waiting. The writer fills the back buffer and swaps it with
+// the middle one, the reader swaps its front buffer with the middle one if
+// that holds something it hasn't seen yet. Values in between are skipped.
+template<class T>
+class TripleBuffer {
+    static constexpr int FRESH = 4; // Set while the middle buffer holds an unread value
+
+    T m_buffers[3];
+    int m_back { 0 };
+    std::atomic<int> m_middle { 1 };
+    int m_front { 2 };
+
+public:
+    explicit TripleBuffer(T const& initial = T {})
+        : m_buffers { initial, initial, initial }
+    {
+    }
+
+    /// Writer thread only
+    T& Back() { return m_buffers[m_back]; }
+    void Publish() { m_back = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel) & 3; }
+
+    /// Reader thread only, the value published last
+    T const& Front()
+    {
+        if (m_middle.load(std::memory_order_relaxed) & FRESH)
+            m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & 3;
+        return m_buffers[m_front];
+    }
+};
@@ -72,11 +72,41 @@
 #define T_WIDGET_STRETCH                T_("Widget.Stretch")
 #define T_SOURCE_ITEM_LABEL             T_("SourceItem.Label")
 #define T_SOURCE_ITEM_VOLUME            T_("SourceItem.Volume")
+#define T_SOURCE_ITEM_MONITOR           T_("SourceItem.Monitor")
 #define T_WIDGET_SOURCE                 T_("Widget.SourceDisplay")
 #define T_WIDGET_SCENE                  T_("Widget.SceneDisplay")
 #define T_WIDGET_AUDIO_MIXER            T_("Widget.AudioMixer")
 #define T_WIDGET_PREVIEW_PROGRAM        T_("Widget.PreviewProgramDisplay")
 #define T_LABEL_CHANNEL_WIDTH           T_("Label.ChannelWidth")
+#define T_MIXER_COMPACT                 T_("AudioMixer.Compact")
+#define T_MULTIVIEW_SOURCE              T_("Source.Multiview")
+#define T_MULTIVIEW_SOURCE_LAYOUT       T_("Source.Multiview.Layout")
+#define T_MULTIVIEW_SOURCE_WIDTH        T_("Source.Multiview.Width")
+#define T_MULTIVIEW_SOURCE_HEIGHT       T_("Source.Multiview.Height")
+#define T_LABEL_WALL                    T_("Label.Wall")
+#define T_LABEL_WALL_NONE               T_("Label.Wall.None")
+#define T_LABEL_WALL_MULTIVIEW          T_("Label.Wall.Multiview")
+#define T_LABEL_WALL_SIZE               T_("Label.Wall.Size")
+#define T_LABEL_WALL_TILE               T_("Label.Wall.Tile")
+#define T_MENU_SNAPSHOT                 T_("Menu.Snapshot")
+#define T_MENU_RENDER_COST              T_("Menu.RenderCost")
+#define T_MENU_FRAME_STATS              T_("Menu.FrameStats")
+#define T_LABEL_SNAPSHOT                T_("Label.Snapshot")
+#define T_LABEL_SNAPSHOT_INTERVAL       T_("Label.Snapshot.Interval")
+#define T_LABEL_SNAPSHOT_OFF            T_("Label.Snapshot.Off")
+#define T_LABEL_SNAPSHOT_FORMAT         T_("Label.Snapshot.Format")
+#define T_LABEL_SNAPSHOT_DIRECTORY      T_("Label.Snapshot.Directory")
+#define T_LABEL_SHM                     T_("Label.Shm")
+#define T_LABEL_SHM_NAME                T_("Label.Shm.Name")
+#define T_LABEL_SHM_FORMAT              T_("Label.Shm.Format")
+#define T_WIDGET_LOUDNESS               T_("Widget.Loudness")
+#define T_LOUDNESS_TARGET               T_("Label.LoudnessTarget")
+#define T_LOUDNESS_RESET                T_("Loudness.Reset")
+#define T_WIDGET_SPECTRUM               T_("Widget.Spectrum")
+#define T_SPECTRUM_HOP                  T_("Label.SpectrumHop")
+#define T_WIDGET_GONIOMETER             T_("Widget.Goniometer")
+#define T_WIDGET_SCOPES                 T_("Widget.Scopes")
+#define T_SCOPES_INTERVAL               T_("Label.ScopesInterval")
 
 #define T_DRAW_SAFE_BORDERS             U_("Basic.Settings.General.Multiview.DrawSafeAreas")
 #define T_RESIZE_WINDOW_CONTENT         U_("ResizeProjectorWindowToContent")
@@ -93,6 +123,8 @@
 #define COLOR_PREVIEW_INDICATOR         0xFF00D000
 #define COLOR_PROGRAM_INDICATOR         0xFFD00000
 #define COLOR_BLACK                     0xFF000000
+#define COLOR_ALARM_VIDEO               0xFFFF8000
+#define COLOR_ALARM_AUDIO               0xFFE020E0
 
 #define ARGB32(a, r, g, b) ((b) | ((g) << 8) | ((r) << 16) | ((a) << 24))
 
@@ -0,0 +1,68 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "vertex_stream.hpp"
+#include "util.h"
+#include <algorithm>
+
+VertexStream::~VertexStream()
+{
+    if (m_vertices) {
+        obs_enter_graphics();
+        gs_vertexbuffer_destroy(m_vertices);
+        obs_leave_graphics();
+    }
+}
+
+vec3* VertexStream::Map(uint32_t count)
+{
+    m_count = 0;
+    if (count > m_capacity || !m_vertices) {
+        uint32_t capacity = std::max(m_capacity, 64u);
+        while (capacity < count)
+            capacity *= 2;
+
+        gs_vertexbuffer_destroy(m_vertices);
+        auto* vbd = gs_vbdata_create();
+        vbd->num = capacity;
+        vbd->points = (vec3*)bzalloc(sizeof(vec3) * capacity);
+        m_vertices = gs_vertexbuffer_create(vbd, GS_DYNAMIC);
+        m_capacity = m_vertices ? capacity : 0;
+        if (!m_vertices) {
+            berr("Failed to create vertex buffer for %u points", capacity);
+            return nullptr;
+        }
+    }
+    m_count = count;
+    return gs_vertexbuffer_get_data(m_vertices)->points;
+}
+
+void VertexStream::Draw(gs_draw_mode mode, uint32_t color)
+{
+    if (!m_vertices || m_count == 0)
+        return;
+
+    gs_effect_t* solid = obs_get_base_effect(OBS_EFFECT_SOLID);
+    gs_effect_set_color(gs_effect_get_param_by_name(solid, "color"), color);
+
+    gs_vertexbuffer_flush(m_vertices);
+    gs_load_vertexbuffer(m_vertices);
+    gs_load_indexbuffer(nullptr);
+    while (gs_effect_loop(solid, "Solid"))
+        gs_draw(mode, 0, m_count);
+    gs_load_vertexbuffer(nullptr);
+}
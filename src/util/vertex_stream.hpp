@@ -0,0 +1,40 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#pragma once
+#include <cstdint>
+#include <obs-module.h>
+
+// Dynamic vertex buffer that is refilled every frame and drawn with a single
+// call of the solid effect, for items that draw many small primitives.
+// The buffer only grows, so steady state rendering doesn't allocate.
+class VertexStream {
+    gs_vertbuffer_t* m_vertices {};
+    uint32_t m_capacity {}, m_count {};
+
+public:
+    VertexStream() = default;
+    VertexStream(VertexStream const&) = delete;
+    VertexStream& operator=(VertexStream const&) = delete;
+    ~VertexStream();
+
+    /// Graphics thread, room for count points or nullptr if the buffer couldn't be created
+    vec3* Map(uint32_t count);
+
+    /// Uploads the points written since Map() and draws them
+    void Draw(gs_draw_mode mode, uint32_t color);
+};
@@ -0,0 +1,221 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "video_scope.hpp"
+#include "util.h"
+#include <algorithm>
+#include <cstring>
+#include <util/platform.h>
+#include <util/sse-intrin.h>
+
+// Hits at which a histogram cell reaches full brightness
+#define WAVEFORM_GAIN 32
+#define VECTORSCOPE_GAIN 16
+#define WAVEFORM_COLOR 0x60FF60
+
+static_assert(VideoScope::SAMPLE_CX % 8 == 0, "Rows are converted eight pixels at a time");
+static_assert(VideoScope::LEVELS == 256, "Histograms are indexed by 8 bit values");
+
+static VideoScope::Image EmptyImage()
+{
+    VideoScope::Image image;
+    image.pixels.resize(VideoScope::IMAGE_CX * VideoScope::IMAGE_CY);
+    return image;
+}
+
+VideoScope::VideoScope()
+    : m_images(EmptyImage())
+{
+    m_workers.setMaxThreadCount(1);
+    m_waveform.resize(LEVELS * SAMPLE_CX);
+    m_vectorscope.resize(LEVELS * LEVELS);
+
+    // Each vectorscope cell is drawn in the color it stands for, at medium luma
+    m_vector_colors.resize(LEVELS * LEVELS);
+    for (uint32_t row = 0; row < LEVELS; row++) {
+        for (uint32_t cb = 0; cb < LEVELS; cb++) {
+            float pb = (cb - 128.f) / 255.f, pr = (127.f - row) / 255.f;
+            auto channel = [](float v) { return uint32_t(std::clamp(v, 0.f, 1.f) * 255.f); };
+            uint32_t r = channel(.5f + 1.5748f * pr);
+            uint32_t g = channel(.5f - 0.1873f * pb - 0.4681f * pr);
+            uint32_t b = channel(.5f + 1.8556f * pb);
+            m_vector_colors[row * LEVELS + cb] = (r << 16) | (g << 8) | b;
+        }
+    }
+}
+
+VideoScope::~VideoScope()
+{
+    m_workers.waitForDone();
+
+    obs_enter_graphics();
+    gs_texture_destroy(m_texture);
+    obs_leave_graphics();
+}
+
+bool VideoScope::BeginCapture(uint32_t cx, uint32_t cy)
+{
+    const uint64_t now = os_gettime_ns();
+    if (cx == 0 || cy == 0 || now < m_next_capture)
+        return false;
+
+    // All copies are still in flight, try again on the next frame
+    m_capture = m_ring.Acquire(SAMPLE_CX, SAMPLE_CY);
+    if (!m_capture || !m_ring.BeginRender(SAMPLE_CX, SAMPLE_CY, cx, cy)) {
+        m_capture = nullptr;
+        return false;
+    }
+    m_next_capture = now + uint64_t(m_interval_ms) * 1000000;
+    return true;
+}
+
+void VideoScope::EndCapture()
+{
+    if (!m_capture)
+        return;
+    m_ring.Stage(m_capture, m_ring.EndRender());
+    m_capture = nullptr;
+}
+
+void VideoScope::Poll()
+{
+    // The surface stays mapped until the worker went through the pixels
+    m_ring.Poll([this](StagingRing::Slot& slot) {
+        auto* s = &slot;
+        m_workers.start([this, s]() { Accumulate(s); });
+        return true;
+    });
+}
+
+gs_texture_t* VideoScope::Texture()
+{
+    auto const& image = m_images.Front();
+    if (image.serial == 0)
+        return nullptr;
+    if (image.serial != m_uploaded) {
+        if (!m_texture && (m_texture = gs_texture_create(IMAGE_CX, IMAGE_CY, GS_BGRA, 1, nullptr, GS_DYNAMIC)))
+            m_textures.Add(IMAGE_CX, IMAGE_CY, 4);
+        if (!m_texture)
+            return nullptr;
+        gs_texture_set_image(m_texture, reinterpret_cast<uint8_t const*>(image.pixels.data()), IMAGE_CX * 4, false);
+        m_uploaded = image.serial;
+    }
+    return m_texture;
+}
+
+void VideoScope::Accumulate(StagingRing::Slot* slot)
+{
+    uint8_t const* data = slot->data[0];
+    const uint32_t linesize = slot->linesize[0];
+
+    std::fill(m_waveform.begin(), m_waveform.end(), 0);
+    std::fill(m_vectorscope.begin(), m_vectorscope.end(), 0);
+
+    const __m128i byte_mask = _mm_set1_epi32(0xff);
+    // BT.709 in 8 bit fixed point
+    const __m128i y_r = _mm_set1_epi16(54), y_g = _mm_set1_epi16(183), y_b = _mm_set1_epi16(19);
+    const __m128i cb_r = _mm_set1_epi16(-29), cb_g = _mm_set1_epi16(-99), cb_b = _mm_set1_epi16(128);
+    const __m128i cr_r = _mm_set1_epi16(128), cr_g = _mm_set1_epi16(-116), cr_b = _mm_set1_epi16(-12);
+    const __m128i offset = _mm_set1_epi16(128);
+    alignas(16) uint16_t luma[8], cb[8], cr[8];
+
+    for (uint32_t y = 0; y < SAMPLE_CY; y++) {
+        auto const* row = data + size_t(y) * linesize;
+        for (uint32_t x = 0; x < SAMPLE_CX; x += 8) {
+            // Eight BGRA pixels split into 16 bit channel vectors
+            const __m128i p0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row + x * 4));
+            const __m128i p1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row + x * 4 + 16));
+            const __m128i b = _mm_packs_epi32(_mm_and_si128(p0, byte_mask), _mm_and_si128(p1, byte_mask));
+            const __m128i g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 8), byte_mask),
+                _mm_and_si128(_mm_srli_epi32(p1, 8), byte_mask));
+            const __m128i r = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 16), byte_mask),
+                _mm_and_si128(_mm_srli_epi32(p1, 16), byte_mask));
+
+            // Luma fits into 16 unsigned bits, chroma into 16 signed bits before the shift
+            __m128i l = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, y_r), _mm_mullo_epi16(g, y_g)), _mm_mullo_epi16(b, y_b));
+            __m128i u = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, cb_r), _mm_mullo_epi16(g, cb_g)), _mm_mullo_epi16(b, cb_b));
+            __m128i v = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, cr_r), _mm_mullo_epi16(g, cr_g)), _mm_mullo_epi16(b, cr_b));
+            l = _mm_srli_epi16(l, 8);
+            u = _mm_min_epi16(_mm_add_epi16(_mm_srai_epi16(u, 8), offset), _mm_set1_epi16(255));
+            v = _mm_min_epi16(_mm_add_epi16(_mm_srai_epi16(v, 8), offset), _mm_set1_epi16(255));
+            _mm_store_si128(reinterpret_cast<__m128i*>(luma), l);
+            _mm_store_si128(reinterpret_cast<__m128i*>(cb), u);
+            _mm_store_si128(reinterpret_cast<__m128i*>(cr), v);
+
+            for (int i = 0; i < 8; i++) {
+                m_waveform[(LEVELS - 1 - luma[i]) * SAMPLE_CX + x + i]++;
+                m_vectorscope[(LEVELS - 1 - cr[i]) * LEVELS + cb[i]]++;
+            }
+        }
+    }
+    // Only the histograms are needed from here on
+    slot->Release();
+
+    auto& image = m_images.Back();
+    BuildImage(image);
+    image.serial = ++m_serial;
+    m_images.Publish();
+}
+
+// Turns 16 hit counts into 16 alpha values, the unsigned pack saturates at 255
+static inline __m128i Intensity(uint32_t const* counts, int gain)
+{
+    const __m128i limit = _mm_set1_epi16(short(255 / gain + 1));
+    const __m128i scale = _mm_set1_epi16(short(gain));
+    __m128i a = _mm_packs_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(counts)),
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(counts + 4)));
+    __m128i b = _mm_packs_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(counts + 8)),
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(counts + 12)));
+    a = _mm_mullo_epi16(_mm_min_epi16(a, limit), scale);
+    b = _mm_mullo_epi16(_mm_min_epi16(b, limit), scale);
+    return _mm_packus_epi16(a, b);
+}
+
+// Writes 16 BGRA pixels, color from rgb and alpha from the intensity
+static inline void StorePixels(uint32_t* out, __m128i alpha, __m128i const* rgb)
+{
+    const __m128i ones = _mm_set1_epi32(-1);
+    const __m128i rgb_mask = _mm_set1_epi32(0x00ffffff);
+    const __m128i lo = _mm_unpacklo_epi8(ones, alpha); // 0xaaff words
+    const __m128i hi = _mm_unpackhi_epi8(ones, alpha);
+    const __m128i px[4] = { _mm_unpacklo_epi16(ones, lo), _mm_unpackhi_epi16(ones, lo), _mm_unpacklo_epi16(ones, hi),
+        _mm_unpackhi_epi16(ones, hi) };
+    for (int i = 0; i < 4; i++) {
+        // Pixels are 0xaaffffff at this point, masking leaves alpha and the color
+        __m128i c = _mm_or_si128(_mm_and_si128(_mm_loadu_si128(rgb + i), rgb_mask), _mm_set1_epi32(int(0xff000000)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), _mm_and_si128(px[i], c));
+    }
+}
+
+void VideoScope::BuildImage(Image& image)
+{
+    __m128i waveform_color[4];
+    for (auto& c : waveform_color)
+        c = _mm_set1_epi32(WAVEFORM_COLOR);
+
+    for (uint32_t row = 0; row < IMAGE_CY; row++) {
+        uint32_t* out = image.pixels.data() + size_t(row) * IMAGE_CX;
+        uint32_t const* waveform = m_waveform.data() + size_t(row) * SAMPLE_CX;
+        for (uint32_t x = 0; x < SAMPLE_CX; x += 16)
+            StorePixels(out + x, Intensity(waveform + x, WAVEFORM_GAIN), waveform_color);
+
+        uint32_t const* vectorscope = m_vectorscope.data() + size_t(row) * LEVELS;
+        auto const* colors = reinterpret_cast<__m128i const*>(m_vector_colors.data() + size_t(row) * LEVELS);
+        for (uint32_t x = 0; x < LEVELS; x += 16)
+            StorePixels(out + SAMPLE_CX + x, Intensity(vectorscope + x, VECTORSCOPE_GAIN), colors + x / 4);
+    }
+}
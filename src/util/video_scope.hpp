@@ -0,0 +1,90 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#pragma once
+#include "resource_usage.hpp"
+#include "staging_ring.hpp"
+#include "triple_buffer.hpp"
+#include <QThreadPool>
+#include <atomic>
+#include <cstdint>
+#include <obs-module.h>
+#include <vector>
+
+// Luma waveform and vectorscope of a video feed. At the configured interval
+// the feed is drawn into a small texture and read back through a StagingRing,
+// so the GPU is never waited on.
+// A worker reads the mapping, builds both histograms and turns them into one
+// BGRA image, which the graphics thread uploads once per update. Memory use
+// is fixed, nothing grows with the size of the feed.
+class VideoScope {
+public:
+    static constexpr uint32_t SAMPLE_CX = 256, SAMPLE_CY = 144;
+    static constexpr uint32_t LEVELS = 256;
+    // Waveform on the left (one column per sample column), vectorscope on the right
+    static constexpr uint32_t IMAGE_CX = SAMPLE_CX + LEVELS, IMAGE_CY = LEVELS;
+
+    struct Image {
+        std::vector<uint32_t> pixels;
+        uint64_t serial {};
+    };
+
+private:
+    // Graphics thread only
+    StagingRing m_ring;
+    gs_texture_t* m_texture {};
+    StagingRing::Slot* m_capture {};
+    uint64_t m_next_capture {}, m_uploaded {};
+    TextureTally m_textures;
+
+    // Worker only
+    std::vector<uint32_t> m_waveform, m_vectorscope; // Hit counts, LEVELS rows each
+    std::vector<uint32_t> m_vector_colors;          // Hue of every vectorscope cell
+    uint64_t m_serial {};
+
+    std::atomic<int> m_interval_ms { 100 };
+    TripleBuffer<Image> m_images;
+    QThreadPool m_workers;
+
+    void Accumulate(StagingRing::Slot* slot);
+    void BuildImage(Image& image);
+
+public:
+    VideoScope();
+    ~VideoScope();
+
+    /// Any thread, time between two updates
+    void SetInterval(int ms) { m_interval_ms = ms; }
+    int Interval() const { return m_interval_ms; }
+
+    /// Graphics thread. Returns true if the feed should be sampled this frame, in that
+    /// case it has to be drawn at cx x cy between BeginCapture() and EndCapture()
+    bool BeginCapture(uint32_t cx, uint32_t cy);
+    void EndCapture();
+
+    /// Graphics thread, once per render. Hands finished copies to the worker
+    void Poll();
+
+    /// Graphics thread, IMAGE_CX x IMAGE_CY texture with the latest scopes, nullptr before the first update
+    gs_texture_t* Texture();
+
+    void AccountResources(ResourceUsage& usage) const
+    {
+        m_ring.AccountResources(usage);
+        m_textures.Account(usage);
+    }
+};
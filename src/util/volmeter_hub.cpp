@@ -0,0 +1,227 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#include "volmeter_hub.hpp"
+#include "util.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <util/platform.h>
+
+// Alarm thresholds, levels in dBFS
+#define SILENCE_LEVEL -60.f
+#define SILENCE_DELAY 10000000000ull
+#define DEAD_LEVEL -80.f
+#define LIVE_LEVEL -50.f
+#define DEAD_DELAY 5000000000ull
+#define CLIP_LEVEL -0.5f
+#define CLIP_COUNT 5
+#define CLIP_WINDOW 3000000000ull
+#define CLIP_HOLD 3000000000ull
+#define STALE_DELAY 500000000ull // Volmeters report every 50 ms by default
+
+namespace VolmeterHub {
+
+static std::mutex entries_mutex;
+static std::map<std::pair<obs_source_t*, obs_fader_type>, std::weak_ptr<Entry>> entries;
+
+void Entry::VolmeterCallback(void* data, const float magnitude[MAX_AUDIO_CHANNELS],
+    const float peak[MAX_AUDIO_CHANNELS], const float input_peak[MAX_AUDIO_CHANNELS])
+{
+    static_cast<Entry*>(data)->Publish(magnitude, peak, input_peak);
+}
+
+Entry::Entry(obs_source_t* src, obs_fader_type type)
+    : m_source(src)
+    , m_type(type)
+{
+    m_volmeter = obs_volmeter_create(type);
+    m_fader = obs_fader_create(type);
+    obs_volmeter_attach_source(m_volmeter, src);
+    obs_fader_attach_source(m_fader, src);
+    obs_volmeter_add_callback(m_volmeter, VolmeterCallback, this);
+
+    struct obs_audio_info oai;
+    m_fallback_channels = obs_get_audio_info(&oai) && oai.speakers == SPEAKERS_MONO ? 1 : 2;
+    m_created = os_gettime_ns();
+}
+
+Entry::~Entry()
+{
+    obs_volmeter_remove_callback(m_volmeter, VolmeterCallback, this);
+    obs_volmeter_detach_source(m_volmeter);
+    obs_volmeter_destroy(m_volmeter);
+    obs_fader_detach_source(m_fader);
+    obs_fader_destroy(m_fader);
+
+    auto published = m_head.load(std::memory_order_relaxed);
+    if (published > 0) {
+        bdebug("Volmeter for '%s': %llu level updates published, %llu skipped by lagging readers",
+            obs_source_get_name(m_source), (unsigned long long)published,
+            (unsigned long long)m_lost.load(std::memory_order_relaxed));
+    }
+
+    std::lock_guard<std::mutex> lock(entries_mutex);
+    auto it = entries.find({ m_source.Get(), m_type });
+    if (it != entries.end() && it->second.expired())
+        entries.erase(it);
+}
+
+void Entry::Publish(const float magnitude[MAX_AUDIO_CHANNELS], const float peak[MAX_AUDIO_CHANNELS],
+    const float input_peak[MAX_AUDIO_CHANNELS])
+{
+    // Only the audio thread of this source writes, so the head needs no read-modify-write
+    uint64_t n = m_head.load(std::memory_order_relaxed);
+    auto& slot = m_history[n % HISTORY];
+
+    slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(slot.sample.magnitude, magnitude, sizeof(slot.sample.magnitude));
+    memcpy(slot.sample.peak, peak, sizeof(slot.sample.peak));
+    memcpy(slot.sample.input_peak, input_peak, sizeof(slot.sample.input_peak));
+    slot.sample.ts = os_gettime_ns();
+    slot.seq.store(2 * n + 2, std::memory_order_release);
+    m_head.store(n + 1, std::memory_order_release);
+    m_last_sample.store(slot.sample.ts, std::memory_order_relaxed);
+
+    EvaluateAlarms(magnitude, peak, slot.sample.ts);
+}
+
+void Entry::EvaluateAlarms(const float magnitude[MAX_AUDIO_CHANNELS], const float peak[MAX_AUDIO_CHANNELS], uint64_t ts)
+{
+    auto& a = m_alarm_state;
+    const int channels = std::min(Channels(), MAX_AUDIO_CHANNELS);
+    const bool muted = obs_source_muted(m_source);
+
+    float loudest = -INFINITY, quietest = INFINITY;
+    bool clipped = false;
+    for (int i = 0; i < channels; i++) {
+        loudest = std::max(loudest, magnitude[i]);
+        quietest = std::min(quietest, magnitude[i]);
+        clipped |= peak[i] >= CLIP_LEVEL;
+    }
+
+    auto held = [ts](uint64_t& since, bool condition, uint64_t delay) {
+        if (!condition) {
+            since = 0;
+            return false;
+        }
+        if (!since)
+            since = ts;
+        return ts - since >= delay;
+    };
+
+    // Muting a source is intentional silence
+    bool silent = held(a.silent_since, !muted && loudest < SILENCE_LEVEL, SILENCE_DELAY);
+    bool dead = held(a.dead_since, !muted && channels > 1 && loudest > LIVE_LEVEL && quietest < DEAD_LEVEL, DEAD_DELAY);
+
+    // A single clipped peak is normal, only a burst of them within the window raises the alarm
+    if (ts - a.clip_window_start > CLIP_WINDOW) {
+        a.clip_window_start = ts;
+        a.clip_count = 0;
+    }
+    if (clipped && ++a.clip_count >= CLIP_COUNT)
+        a.clip_until = ts + CLIP_HOLD;
+
+    AudioAlarm alarm = AudioAlarm::None;
+    if (ts < a.clip_until)
+        alarm = AudioAlarm::Clipping;
+    else if (dead)
+        alarm = AudioAlarm::DeadChannel;
+    else if (silent)
+        alarm = AudioAlarm::Silence;
+    m_alarm.store(alarm, std::memory_order_relaxed);
+}
+
+AudioAlarm Entry::Alarm() const
+{
+    const uint64_t now = os_gettime_ns();
+    const uint64_t last = m_last_sample.load(std::memory_order_relaxed);
+    if (last && now - last < STALE_DELAY)
+        return m_alarm.load(std::memory_order_relaxed);
+
+    // Sources that stop producing audio stop the callbacks too, nothing clears the last alarm
+    const uint64_t quiet_since = last ? last : m_created;
+    const bool has_audio = obs_source_get_output_flags(m_source) & OBS_SOURCE_AUDIO;
+    if (has_audio && obs_source_active(m_source) && !obs_source_muted(m_source) && now - quiet_since >= SILENCE_DELAY)
+        return AudioAlarm::Silence;
+    return AudioAlarm::None;
+}
+
+bool Entry::Read(uint64_t& cursor, LevelSample& out)
+{
+    uint64_t head = m_head.load(std::memory_order_acquire);
+    if (head == cursor)
+        return false;
+
+    if (head - cursor > HISTORY) {
+        m_lost.fetch_add(head - cursor - HISTORY, std::memory_order_relaxed);
+        cursor = head - HISTORY;
+    }
+
+    bool merged = false;
+    for (uint64_t n = cursor; n < head; n++) {
+        auto const& slot = m_history[n % HISTORY];
+        LevelSample sample;
+
+        if (slot.seq.load(std::memory_order_acquire) != 2 * n + 2)
+            continue;
+        memcpy(&sample, &slot.sample, sizeof(sample));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != 2 * n + 2) {
+            // The audio thread lapped us while copying
+            m_lost.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        // Samples are visited oldest first, so magnitude and time end up being the latest
+        for (int i = 0; i < MAX_AUDIO_CHANNELS; i++) {
+            out.magnitude[i] = sample.magnitude[i];
+            out.peak[i] = merged ? std::max(out.peak[i], sample.peak[i]) : sample.peak[i];
+            out.input_peak[i] = merged ? std::max(out.input_peak[i], sample.input_peak[i]) : sample.input_peak[i];
+        }
+        out.ts = sample.ts;
+        merged = true;
+    }
+    cursor = head;
+    return merged;
+}
+
+int Entry::Channels() const
+{
+    int channels = obs_volmeter_get_nr_channels(m_volmeter);
+    return channels ? channels : m_fallback_channels;
+}
+
+EntryRef Subscribe(obs_source_t* src, obs_fader_type type)
+{
+    if (!src)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(entries_mutex);
+    auto& weak = entries[{ src, type }];
+    auto entry = weak.lock();
+    if (!entry) {
+        entry = std::make_shared<Entry>(src, type);
+        weak = entry;
+    }
+    return entry;
+}
+
+}
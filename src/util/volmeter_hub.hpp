@@ -0,0 +1,111 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <obs.hpp>
+
+// Raw levels as reported by a volmeter on the audio thread
+struct LevelSample {
+    float magnitude[MAX_AUDIO_CHANNELS];
+    float peak[MAX_AUDIO_CHANNELS];
+    float input_peak[MAX_AUDIO_CHANNELS];
+    uint64_t ts;
+};
+
+// Owns one volmeter and one fader per source and fader type, shared by
+// every meter and slider showing that source in any window. The audio
+// callback only writes the sample into a small history ring, readers
+// keep their own cursor into it, so the audio thread does the same
+// amount of work no matter how many displays subscribed.
+namespace VolmeterHub {
+
+enum class AudioAlarm : uint8_t {
+    None,
+    Silence,     // All channels quiet for a long time while not muted
+    Clipping,    // Repeated clipping within a few seconds
+    DeadChannel, // One channel silent while another one carries signal
+};
+
+class Entry {
+    static constexpr uint64_t HISTORY = 16;
+
+    // Seqlock per slot: odd while the audio thread writes it, 2 * n + 2 once sample n is complete
+    struct Slot {
+        std::atomic<uint64_t> seq {};
+        LevelSample sample {};
+    };
+
+    OBSSource m_source;
+    obs_fader_type m_type;
+    obs_volmeter_t* m_volmeter {};
+    obs_fader_t* m_fader {};
+    int m_fallback_channels {}; // Until the volmeter knows the channels of the source
+    uint64_t m_created {};
+
+    Slot m_history[HISTORY];
+    std::atomic<uint64_t> m_head {}; // Number of published samples
+    std::atomic<uint64_t> m_last_sample {}; // Time of the latest callback, 0 before the first one
+
+    std::atomic<uint64_t> m_lost {}; // Samples a reader skipped because it fell behind
+
+    // Alarm state machines, fed by the volmeter callback on the audio thread
+    struct AlarmState {
+        uint64_t silent_since {}, dead_since {}; // 0 while the condition isn't met
+        uint64_t clip_window_start {}, clip_until {};
+        int clip_count {};
+    } m_alarm_state;
+    std::atomic<AudioAlarm> m_alarm { AudioAlarm::None };
+
+    void EvaluateAlarms(const float magnitude[MAX_AUDIO_CHANNELS], const float peak[MAX_AUDIO_CHANNELS], uint64_t ts);
+
+    static void VolmeterCallback(void* data, const float magnitude[MAX_AUDIO_CHANNELS],
+        const float peak[MAX_AUDIO_CHANNELS], const float input_peak[MAX_AUDIO_CHANNELS]);
+
+    void Publish(const float magnitude[MAX_AUDIO_CHANNELS], const float peak[MAX_AUDIO_CHANNELS],
+        const float input_peak[MAX_AUDIO_CHANNELS]);
+
+public:
+    Entry(obs_source_t* src, obs_fader_type type);
+    ~Entry();
+
+    /// Position a new reader starts at, it only sees samples published after this
+    uint64_t Cursor() const { return m_head.load(std::memory_order_acquire); }
+
+    /// Merges all samples published since cursor into out (max of the peaks, latest magnitude)
+    /// and advances the cursor. Returns false if nothing new arrived
+    bool Read(uint64_t& cursor, LevelSample& out);
+
+    int Channels() const;
+
+    /// Any thread. The alarm the callbacks raised goes away once they stop, unless the source
+    /// is active and not muted, then no audio for a while is silence
+    AudioAlarm Alarm() const;
+    obs_fader_t* Fader() const { return m_fader; }
+    obs_source_t* Source() const { return m_source; }
+    obs_fader_type Type() const { return m_type; }
+};
+
+using EntryRef = std::shared_ptr<Entry>;
+
+/// Returns the shared entry for the source, creating it if this is the first subscriber.
+/// The entry is destroyed once the last reference is dropped
+EntryRef Subscribe(obs_source_t* src, obs_fader_type type);
+
+}
@@ -18,11 +18,12 @@
 #include "volume_meter.hpp"
 #include "util.h"
 #include <QTimer>
+#include <cmath>
 #include <obs.hpp>
 #include <util/platform.h>
+#include <util/profiler.hpp>
 #include <util/util.hpp>
 
-#define CLAMP(x, min, max) ((x) < (min) ? (min) : ((x) > (max) ? (max) : (x)))
 #define FADER_PRECISION 4096.0
 
 // Size of the audio indicator in pixels
@@ -35,14 +36,6 @@ static void on_source_muted(void* data, calldata_t* calldata)
     meter->SetMuted(calldata_bool(calldata, "muted"));
 }
 
-static void volume_meter(void* data,
-    const float magnitude[MAX_AUDIO_CHANNELS],
-    const float peak[MAX_AUDIO_CHANNELS],
-    const float inputPeak[MAX_AUDIO_CHANNELS])
-{
-    static_cast<MixerMeter*>(data)->Update(magnitude, peak, inputPeak);
-}
-
 void MixerMeter::draw_rectangle(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t c)
 {
     if (!(w > 0 && h > 0))
@@ -97,56 +90,29 @@ MixerMeter::MixerMeter(OBSSource src, int x, int y, int height, int channel_widt
 
 MixerMeter::~MixerMeter()
 {
-    // Detach from source first to prevent callbacks during destruction
-    if (m_meter) {
-        obs_volmeter_remove_callback(m_meter, volume_meter, this);
-        obs_volmeter_detach_source(m_meter);
-    }
-
     // Disconnect all signals
     if (m_source) {
         mute_signal.Disconnect();
         vol_changed_signal.Disconnect();
-        rename_signal.Disconnect();
     }
 
-    // Now safe to destroy the volume meter
-    if (m_meter)
-        obs_volmeter_destroy(m_meter);
+    ReleaseLanes();
 }
 
-void MixerMeter::SetType(obs_fader_type t)
+void MixerMeter::Subscribe()
 {
-    obs_volmeter_remove_callback(m_meter, volume_meter, this);
-    obs_volmeter_destroy(m_meter);
-    m_meter = obs_volmeter_create(t);
-    obs_volmeter_add_callback(m_meter, volume_meter, this);
-    m_channels = obs_volmeter_get_nr_channels(m_meter);
+    m_levels = VolmeterHub::Subscribe(m_source, m_type);
+    if (m_levels) {
+        m_levels_cursor = m_levels->Cursor();
+        m_channels = m_levels->Channels();
+    }
 }
 
-void MixerMeter::Update(const float magnitude[], const float peak[], const float inputPeak[])
+void MixerMeter::SetType(obs_fader_type t)
 {
-    uint64_t ts = os_gettime_ns();
-    QMutexLocker locker(&m_data_mutex);
-
-    m_current_last_update_time = ts;
-
-    if (m_clipping) {
-        if ((ts - m_clip_begin_time) * 0.000001 > CLIP_FLASH_DURATION_MS) {
-            m_clipping = false;
-        }
-    }
-
-    for (int channelNr = 0; channelNr < MAX_AUDIO_CHANNELS; channelNr++) {
-        m_current_magnitude[channelNr] = magnitude[channelNr];
-        m_current_peak[channelNr] = peak[channelNr];
-        m_current_input_peak[channelNr] = inputPeak[channelNr];
-    }
-
-    // In case there are more updates then redraws we must make sure
-    // that the ballistics of peak and hold are recalculated.
-    locker.unlock();
-    CalculateBallistics(ts);
+    m_type = t;
+    if (m_source)
+        Subscribe();
 }
 
 void MixerMeter::SetSource(OBSSource src)
@@ -155,7 +121,6 @@ void MixerMeter::SetSource(OBSSource src)
     if (m_source) {
         mute_signal.Disconnect();
         vol_changed_signal.Disconnect();
-        rename_signal.Disconnect();
     }
 
     m_source = src;
@@ -172,244 +137,104 @@ void MixerMeter::SetSource(OBSSource src)
                 static_cast<MixerMeter*>(d)->OnSourceVolumeChanged();
             },
             this);
-        rename_signal.Connect(
-            handler, "rename", [](void* d, calldata_t*) {
-                static_cast<MixerMeter*>(d)->OnSourceNameChanged();
-            },
-            this);
     }
 
-    if (m_meter) {
-        int currentNrAudioChannels = obs_volmeter_get_nr_channels(m_meter);
-
+    if (src)
         m_muted = obs_source_muted(src);
-        if (!currentNrAudioChannels) {
-            struct obs_audio_info oai;
-            obs_get_audio_info(&oai);
-            currentNrAudioChannels = (oai.speakers == SPEAKERS_MONO) ? 1 : 2;
-        }
-        m_channels = currentNrAudioChannels;
-
-        obs_volmeter_detach_source(m_meter);
-        obs_volmeter_attach_source(m_meter, m_source);
-    }
+    Subscribe();
 }
 
-inline void
-MixerMeter::CalculateBallisticsForChannel(int channelNr, uint64_t ts,
-    qreal timeSinceLastRedraw)
+void MixerMeter::AttachLanes(MeterBank& bank, int channels)
 {
-    if (m_current_peak[channelNr] >= m_display_peak[channelNr] || isnan(m_display_peak[channelNr])) {
-        // Attack of peak is immediate.
-        m_display_peak[channelNr] = m_current_peak[channelNr];
-    } else {
-        // Decay of peak is 40 dB / 1.7 seconds for Fast Profile
-        // 20 dB / 1.7 seconds for Medium Profile (Type I PPM)
-        // 24 dB / 2.8 seconds for Slow Profile (Type II PPM)
-        float decay = float(m_peak_decay_rate * timeSinceLastRedraw);
-        m_display_peak[channelNr] = CLAMP(m_display_peak[channelNr] - decay,
-            m_current_peak[channelNr], 0);
-    }
+    ReleaseLanes();
+    MeterBank::Params params { m_minimum_level, m_peak_decay_rate, m_magnitude_integration_time,
+        m_peak_hold_duration, m_input_peak_hold_duration };
 
-    if (m_current_peak[channelNr] >= m_display_peak_hold[channelNr] || !isfinite(m_display_peak_hold[channelNr])) {
-        // Attack of peak-hold is immediate, but keep track
-        // when it was last updated.
-        m_display_peak_hold[channelNr] = m_current_peak[channelNr];
-        m_display_peak_hold_last_update_time[channelNr] = ts;
-    } else {
-        // The peak and hold falls back to peak
-        // after 20 seconds.
-        qreal timeSinceLastPeak = (uint64_t)(ts - m_display_peak_hold_last_update_time[channelNr]) * 0.000000001;
-        if (timeSinceLastPeak > m_peak_hold_duration) {
-            m_display_peak_hold[channelNr] = m_current_peak[channelNr];
-            m_display_peak_hold_last_update_time[channelNr] = ts;
-        }
-    }
-
-    if (m_current_input_peak[channelNr] >= m_display_input_peak_hold[channelNr] || !isfinite(m_display_input_peak_hold[channelNr])) {
-        // Attack of peak-hold is immediate, but keep track
-        // when it was last updated.
-        m_display_input_peak_hold[channelNr] = m_current_input_peak[channelNr];
-        m_display_input_peak_hold_last_upate_time[channelNr] = ts;
-    } else {
-        // The peak and hold falls back to peak after 1 second.
-        qreal timeSinceLastPeak = (uint64_t)(ts - m_display_input_peak_hold_last_upate_time[channelNr]) * 0.000000001;
-        if (timeSinceLastPeak > m_input_peak_hold_duration) {
-            m_display_input_peak_hold[channelNr] = m_current_input_peak[channelNr];
-            m_display_input_peak_hold_last_upate_time[channelNr] = ts;
-        }
-    }
+    m_bank = &bank;
+    for (m_lane_count = 0; m_lane_count < channels; m_lane_count++)
+        m_lanes[m_lane_count] = bank.Allocate(params);
+}
 
-    if (!isfinite(m_display_magnitude[channelNr])) {
-        // The statements in the else-leg do not work with
-        // NaN and infinite displayMagnitude.
-        m_display_magnitude[channelNr] = m_current_magnitude[channelNr];
-    } else {
-        // A VU meter will integrate to the new value to 99% in 300 ms.
-        // The calculation here is very simplified and is more accurate
-        // with higher frame-rate.
-        float attack = float((m_current_magnitude[channelNr] - m_display_magnitude[channelNr]) * (timeSinceLastRedraw / m_magnitude_integration_time) * 0.99);
-        m_display_magnitude[channelNr] = CLAMP(m_display_magnitude[channelNr] + attack,
-            (float)m_minimum_level, 0);
-    }
+void MixerMeter::ReleaseLanes()
+{
+    for (int i = 0; m_bank && i < m_lane_count; i++)
+        m_bank->Release(m_lanes[i]);
+    m_bank = nullptr;
+    m_lane_count = 0;
 }
 
-void MixerMeter::Render(float cell_scale, float, float src_scale_y)
+void MixerMeter::Render(MeterBatch& batch, Geometry const& g, float cell_scale, float, float src_scale_y)
 {
+    ProfileScope("MixerMeter::Render");
     uint64_t ts = os_gettime_ns();
-    qreal timeSinceLastRedraw = (ts - m_last_redraw_time) * 0.000000001;
-    CalculateBallistics(ts, timeSinceLastRedraw);
+    const int channels = qMin(m_channels, MAX_AUDIO_CHANNELS);
+
+    // Ballistics run for all meters of the layout at once when the batch is drawn
+    auto& bank = batch.Bank();
+    if (m_bank != &bank || m_lane_count != channels)
+        AttachLanes(bank, channels);
+
+    if (m_levels && m_levels->Read(m_levels_cursor, m_sample)) {
+        m_current_last_update_time = m_sample.ts;
+        for (int i = 0; i < m_lane_count; i++)
+            bank.SetLevels(m_lanes[i], m_sample.magnitude[i], m_sample.peak[i], m_sample.input_peak[i]);
+    }
+
+    if (m_clipping && (ts - m_clip_begin_time) * 0.000001 > CLIP_FLASH_DURATION_MS)
+        m_clipping = false;
+
     bool idle = DetectIdle(ts);
 
-    const auto bottom_indicator_size = m_channel_width / cell_scale;
-    auto h = (m_height - bottom_indicator_size * 2) * src_scale_y; // do not include indicator and mute button in height
-    for (int i = 0; i < m_channels; i++) {
-        auto magnitude = m_display_magnitude[i];
-        auto peak = m_display_peak[i];
-        auto peak_hold = m_display_peak_hold[i];
-        qreal scale = h / m_minimum_level;
-
-        QMutexLocker locker(&m_data_mutex);
-        int lower_limit = m_y + h;
-        int upper_limit = m_y;
-        //        int magnitude_position = int(lower_limit - (magnitude * scale));
-        int peak_position = int(lower_limit - (h - (peak * scale)));
-        int peak_hold_position = int(lower_limit - (h - (peak_hold * scale)));
-        int nominal_position = int(upper_limit + (m_warning_level * scale));
-        int warning_position = int(upper_limit + (m_error_level * scale));
-        int magnitude_position = int(lower_limit - (h - (magnitude * scale)));
-        int nominal_ength = lower_limit - nominal_position;
-        int warning_length = nominal_position - warning_position;
-        int error_length = warning_position - upper_limit;
-        int error_position = 0;
-
-        locker.unlock();
-        auto w = m_channel_width / cell_scale;
-        auto x = m_x + (w + 2) * i;
-
-        if (m_clipping)
-            peak_position = 0;
-
-        if (peak_position > lower_limit) { // Peak is below the meter -> no peak visible
-            draw_rectangle(x, nominal_position, w, nominal_ength,
-                m_muted ? m_background_nominal_color_disabled
-                        : m_background_nominal_color);
-            draw_rectangle(x, warning_position, w, warning_length,
-                m_muted ? m_background_warning_color_disabled
-                        : m_background_warning_color);
-            draw_rectangle(x, upper_limit, w, error_length,
-                m_muted ? m_background_error_color_disabled
-                        : m_background_error_color);
-        } else if (peak_position > nominal_position) {
-            // Nominal (green + background)
-            draw_rectangle(x, peak_position, w,
-                lower_limit - peak_position,
-                m_muted ? m_foreground_nominal_color_disabled
-                        : m_foreground_nominal_color);
-            draw_rectangle(x, nominal_position, w,
-                peak_position - nominal_position,
-                m_muted ? m_background_nominal_color_disabled
-                        : m_background_nominal_color);
-
-            // Warning (yellow) and error (red)
-            draw_rectangle(x, warning_position, w, warning_length,
-                m_muted ? m_background_warning_color_disabled
-                        : m_background_warning_color);
-            draw_rectangle(x, upper_limit, w, error_length,
-                m_muted ? m_background_error_color_disabled
-                        : m_background_error_color);
-        } else if (peak_position > warning_position) {
-            draw_rectangle(x, nominal_position, w, nominal_ength,
-                m_muted ? m_foreground_nominal_color_disabled
-                        : m_foreground_nominal_color);
-
-            // Warning (yellow + background)
-            draw_rectangle(x, peak_position, w,
-                nominal_position - peak_position,
-                m_muted ? m_foreground_warning_color_disabled
-                        : m_foreground_warning_color);
-            draw_rectangle(x, warning_position, w,
-                peak_position - warning_position,
-                m_muted ? m_background_warning_color_disabled
-                        : m_background_warning_color);
-
-            draw_rectangle(x, upper_limit, w, error_length,
-                m_muted ? m_background_error_color_disabled
-                        : m_background_error_color);
-        } else if (peak_position > error_position && peak_position > upper_limit) {
-            draw_rectangle(x, peak_position, w, warning_position - peak_position,
-                m_muted ? m_foreground_error_color_disabled
-                        : m_foreground_error_color);
-            draw_rectangle(x, upper_limit, w, peak_position - upper_limit,
-                m_muted ? m_background_error_color_disabled
-                        : m_background_error_color);
-
-            draw_rectangle(x, nominal_position, w, nominal_ength,
-                m_muted ? m_foreground_nominal_color_disabled
-                        : m_foreground_nominal_color);
-            draw_rectangle(x, warning_position, w, warning_length,
-                m_muted ? m_foreground_warning_color_disabled
-                        : m_foreground_warning_color);
-        } else {
-            if (!m_clipping) {
-                m_clip_begin_time = os_gettime_ns();
-                m_clipping = true;
-            }
-            int end = error_length + warning_length + nominal_ength;
-
-            draw_rectangle(x, upper_limit, w, end,
-                m_muted ? m_foreground_error_color_disabled
-                        : m_foreground_error_color);
-        }
+    if (channels <= 0)
+        return;
 
-        auto size = 3 / cell_scale;
-        if (peak_hold_position - size > lower_limit)
-            ;
-        else if (peak_hold_position - size / 2 > nominal_position)
-            draw_rectangle(x, peak_hold_position, w, size,
-                m_muted ? m_foreground_nominal_color_disabled
-                        : m_foreground_nominal_color);
-        else if (peak_hold_position - size / 2 > warning_position)
-            draw_rectangle(x, peak_hold_position, w, size,
-                m_muted ? m_foreground_warning_color_disabled
-                        : m_foreground_warning_color);
-        else if (peak_hold_position - size / 2 > upper_limit)
-            draw_rectangle(x, peak_hold_position, w, size,
-                m_muted ? m_foreground_error_color_disabled
-                        : m_foreground_error_color);
-
-        if (magnitude_position - size / 2 >= upper_limit) {
-            draw_rectangle(x, magnitude_position - size / 2, w, size,
-                m_magnitude_color);
-        }
+    const auto bottom_indicator_size = g.channel_width / cell_scale;
+    const float h = (g.height - bottom_indicator_size * 2) * src_scale_y; // do not include indicator and mute button in height
+    const float w = g.channel_width / cell_scale;
+    const float indicator_offset = 1 / cell_scale;
+    const float width = ceilf((w + 2) * channels - 2);
+    const float height = ceilf(h + indicator_offset + w);
 
-        if (idle)
-            continue;
-
-        auto input_peak_hold = m_display_input_peak_hold[i];
-        uint32_t color;
-        if (input_peak_hold < m_minimum_input_level)
-            color = m_background_nominal_color;
-        else if (input_peak_hold < m_warning_level)
-            color = m_foreground_nominal_color;
-        else if (input_peak_hold < m_error_level)
-            color = m_foreground_warning_color;
-        else if (input_peak_hold <= m_clip_level)
-            color = m_foreground_error_color;
-        else
-            color = m_clip_color;
-
-        draw_rectangle(x, lower_limit + 1 / cell_scale, w, w, color);
-    }
-    m_last_redraw_time = ts;
-}
+    if (width <= 0 || height <= 0 || h <= 0)
+        return;
 
-inline void MixerMeter::CalculateBallistics(uint64_t ts,
-    qreal timeSinceLastRedraw)
-{
-    QMutexLocker locker(&m_data_mutex);
+    MeterBatch::Style style;
+    style.minimum_level = m_minimum_level;
+    style.warning_level = m_warning_level;
+    style.error_level = m_error_level;
+    style.clip_level = m_clip_level;
+    style.minimum_input_level = m_minimum_input_level;
+    style.background_nominal = m_background_nominal_color;
+    style.background_warning = m_background_warning_color;
+    style.background_error = m_background_error_color;
+    style.foreground_nominal = m_foreground_nominal_color;
+    style.foreground_warning = m_foreground_warning_color;
+    style.foreground_error = m_foreground_error_color;
+    style.background_nominal_disabled = m_background_nominal_color_disabled;
+    style.background_warning_disabled = m_background_warning_color_disabled;
+    style.background_error_disabled = m_background_error_color_disabled;
+    style.foreground_nominal_disabled = m_foreground_nominal_color_disabled;
+    style.foreground_warning_disabled = m_foreground_warning_color_disabled;
+    style.foreground_error_disabled = m_foreground_error_color_disabled;
+    style.magnitude = m_magnitude_color;
+    style.clip = m_clip_color;
+
+    auto* instance = batch.Add(g.x, g.y, width, height, style, m_lanes, m_lane_count);
+    if (!instance)
+        return;
+
+    for (int i = 0; i < channels; i++) {
+        // Peak reaching the top of the meter starts the clip indicator. The displayed
+        // peak is only updated when the batch is drawn, but it never exceeds the larger
+        // one of the new peak and the peak of the last frame
+        float peak = qMax(bank.CurrentPeak(m_lanes[i]), bank.Peak(m_lanes[i]));
+        if (h * peak / m_minimum_level < 1 && !m_clipping) {
+            m_clip_begin_time = ts;
+            m_clipping = true;
+        }
+    }
 
-    for (int channelNr = 0; channelNr < MAX_AUDIO_CHANNELS; channelNr++)
-        CalculateBallisticsForChannel(channelNr, ts,
-            timeSinceLastRedraw);
+    vec4_set(&instance->geometry, channels, w, w + 2, h);
+    vec4_set(&instance->state, m_muted, m_clipping, idle, INDICATOR_THICKNESS / cell_scale);
+    vec4_set(&instance->extra, indicator_offset, 0, 0, 0);
 }
@@ -16,8 +16,9 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *************************************************************************/
 #pragma once
+#include "meter_batch.hpp"
+#include "volmeter_hub.hpp"
 #include <QColor>
-#include <QMutex>
 #include <QtGlobal>
 #include <cstdint>
 #include <obs-module.h>
@@ -27,36 +28,39 @@ class MixerMeter {
 protected:
     bool m_muted = false;
     uint64_t m_clip_begin_time = 0;
-    uint64_t m_last_redraw_time = 0;
     uint64_t m_current_last_update_time = 0;
     int m_channels = 0;
     bool m_clipping = false;
     OBSSource m_source;
-    obs_volmeter_t* m_meter {};
+    obs_fader_type m_type = OBS_FADER_LOG;
 
     int m_x, m_y, m_height, m_channel_width;
 
-    float m_current_magnitude[MAX_AUDIO_CHANNELS];
-    float m_current_peak[MAX_AUDIO_CHANNELS];
-    float m_current_input_peak[MAX_AUDIO_CHANNELS];
-
-    float m_display_magnitude[MAX_AUDIO_CHANNELS];
-    float m_display_peak[MAX_AUDIO_CHANNELS];
-    float m_display_peak_hold[MAX_AUDIO_CHANNELS];
-    uint64_t m_display_peak_hold_last_update_time[MAX_AUDIO_CHANNELS];
-    float m_display_input_peak_hold[MAX_AUDIO_CHANNELS];
-    uint64_t m_display_input_peak_hold_last_upate_time[MAX_AUDIO_CHANNELS];
-
-    qreal m_minimum_level;
-    qreal m_warning_level;
-    qreal m_error_level;
-    qreal m_clip_level;
-    qreal m_minimum_input_level;
-    qreal m_peak_decay_rate;
-    qreal m_magnitude_integration_time;
-    qreal m_peak_hold_duration;
-    qreal m_input_peak_hold_duration;
-    QMutex m_data_mutex;
+    // Ballistics state lives in the meter bank of the layout this meter is rendered in
+    MeterBank* m_bank {};
+    int m_lanes[MAX_AUDIO_CHANNELS] {};
+    int m_lane_count = 0;
+
+    void AttachLanes(MeterBank& bank, int channels);
+    void ReleaseLanes();
+
+    float m_minimum_level;
+    float m_warning_level;
+    float m_error_level;
+    float m_clip_level;
+    float m_minimum_input_level;
+    float m_peak_decay_rate;
+    float m_magnitude_integration_time;
+    float m_peak_hold_duration;
+    float m_input_peak_hold_duration;
+
+    // Volmeter and fader are shared with every other display of the same source
+    VolmeterHub::EntryRef m_levels;
+    uint64_t m_levels_cursor = 0;
+    LevelSample m_sample {}; // Only touched by the render thread
+
+    void Subscribe();
+    obs_fader_t* Fader() const { return m_levels ? m_levels->Fader() : nullptr; }
 
     uint32_t m_background_nominal_color;
     uint32_t m_background_warning_color;
@@ -83,12 +87,16 @@ protected:
     OBSSignal mixersSignal;
     OBSSignal mute_signal;
     OBSSignal deactivateSignal;
-    OBSSignal rename_signal;
 
-    virtual void OnSourceNameChanged() { }
     virtual void OnSourceVolumeChanged() { }
 
 public:
+    // Where the meter is drawn. The mixer lays out its sliders on the UI thread and hands
+    // the result to the render thread with its view, so the two never share these
+    struct Geometry {
+        int x, y, height, channel_width;
+    };
+
     MixerMeter(OBSSource, int x = 10, int y = 10, int height = 100, int channel_width = 3);
     ~MixerMeter();
 
@@ -107,31 +115,28 @@ public:
 
     void SetMuted(bool m) { m_muted = m; }
 
-    void Update(const float magnitude[MAX_AUDIO_CHANNELS],
-        const float peak[MAX_AUDIO_CHANNELS],
-        const float inputPeak[MAX_AUDIO_CHANNELS]);
-
     void ResetLevels()
     {
         m_current_last_update_time = 0;
-        for (int channelNr = 0; channelNr < MAX_AUDIO_CHANNELS; channelNr++) {
-            m_current_magnitude[channelNr] = -M_INFINITE;
-            m_current_peak[channelNr] = -M_INFINITE;
-            m_current_input_peak[channelNr] = -M_INFINITE;
-
-            m_display_magnitude[channelNr] = -M_INFINITE;
-            m_display_peak[channelNr] = -M_INFINITE;
-            m_display_peak_hold[channelNr] = -M_INFINITE;
-            m_display_peak_hold_last_update_time[channelNr] = 0;
-            m_display_input_peak_hold[channelNr] = -M_INFINITE;
-            m_display_input_peak_hold_last_upate_time[channelNr] = 0;
-        }
+        for (int i = 0; m_bank && i < m_lane_count; i++)
+            m_bank->Reset(m_lanes[i]);
     }
 
+    /// Render thread, aged against the latest audio of the source
+    VolmeterHub::AudioAlarm GetAlarm() const
+    {
+        return m_levels ? m_levels->Alarm() : VolmeterHub::AudioAlarm::None;
+    }
+
+    void AccountResources(ResourceUsage& usage) const { usage.AddMeter(m_levels.get()); }
+
+    obs_source_t* GetSource() const { return m_source; }
     int GetX() const { return m_x; }
     int GetY() const { return m_y; }
     int GetHeight() const { return m_height; }
-    int GetWidth() const { return (m_channel_width + 2) * m_channels; }
+    int GetWidth() const { return GetWidth(m_channel_width); }
+    int GetWidth(int channel_width) const { return (channel_width + 2) * m_channels; }
+    Geometry GetGeometry() const { return { m_x, m_y, m_height, m_channel_width }; }
     void SetPos(int x, int y)
     {
         m_x = x;
@@ -145,13 +150,11 @@ public:
 
     virtual void SetSource(OBSSource);
 
-    virtual void Render(float cell_scale, float source_scale_x, float source_scale_y);
-
-    void CalculateBallistics(uint64_t ts,
-        qreal timeSinceLastRedraw = 0.0);
-
-    void CalculateBallisticsForChannel(int channelNr, uint64_t ts,
-        qreal timeSinceLastRedraw = 0.0);
+    void Render(MeterBatch& batch, Geometry const& g, float cell_scale, float source_scale_x, float source_scale_y);
+    void Render(MeterBatch& batch, float cell_scale, float source_scale_x, float source_scale_y)
+    {
+        Render(batch, GetGeometry(), cell_scale, source_scale_x, source_scale_y);
+    }
 
     void SetChannelWidth(int w)
     {
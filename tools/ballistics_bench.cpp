@@ -0,0 +1,289 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+
+// Checks that the SIMD meter ballistics match the scalar reference bit for bit
+// and times the meter ballistics of a layout before and after they moved to the
+// once per frame meter bank. The old path is kept here as it was: every meter
+// ran all MAX_AUDIO_CHANNELS in double precision under its data mutex, once
+// per audio callback and once per rendered frame.
+// Exits with a non-zero status if the kernels diverge:
+//   ballistics_bench [frames]
+#include "../src/util/meter_bank.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <graphics/math-defs.h>
+#include <media-io/audio-io.h>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#define CLAMP(x, min, max) ((x) < (min) ? (min) : ((x) > (max) ? (max) : (x)))
+#define CHANNELS 2
+#define FRAME_NS 16666667ull
+#define CALLBACK_NS 21333333ull // 1024 samples at 48 kHz
+
+// Ballistics state of one meter before the meter bank
+struct LegacyMeter {
+    std::mutex data_mutex;
+    float current_magnitude[MAX_AUDIO_CHANNELS], current_peak[MAX_AUDIO_CHANNELS], current_input_peak[MAX_AUDIO_CHANNELS];
+    float display_magnitude[MAX_AUDIO_CHANNELS], display_peak[MAX_AUDIO_CHANNELS], display_peak_hold[MAX_AUDIO_CHANNELS];
+    uint64_t display_peak_hold_last_update_time[MAX_AUDIO_CHANNELS];
+    float display_input_peak_hold[MAX_AUDIO_CHANNELS];
+    uint64_t display_input_peak_hold_last_update_time[MAX_AUDIO_CHANNELS];
+
+    double minimum_level = -60.0, peak_decay_rate = 11.76, magnitude_integration_time = 0.3;
+    double peak_hold_duration = 20.0, input_peak_hold_duration = 1.0;
+
+    LegacyMeter()
+    {
+        for (int i = 0; i < MAX_AUDIO_CHANNELS; i++) {
+            current_magnitude[i] = current_peak[i] = current_input_peak[i] = -M_INFINITE;
+            display_magnitude[i] = display_peak[i] = display_peak_hold[i] = display_input_peak_hold[i] = -M_INFINITE;
+            display_peak_hold_last_update_time[i] = display_input_peak_hold_last_update_time[i] = 0;
+        }
+    }
+
+    void CalculateBallisticsForChannel(int c, uint64_t ts, double time_since_last_redraw)
+    {
+        if (current_peak[c] >= display_peak[c] || std::isnan(display_peak[c])) {
+            display_peak[c] = current_peak[c];
+        } else {
+            float decay = float(peak_decay_rate * time_since_last_redraw);
+            display_peak[c] = CLAMP(display_peak[c] - decay, current_peak[c], 0);
+        }
+
+        if (current_peak[c] >= display_peak_hold[c] || !std::isfinite(display_peak_hold[c])) {
+            display_peak_hold[c] = current_peak[c];
+            display_peak_hold_last_update_time[c] = ts;
+        } else if ((ts - display_peak_hold_last_update_time[c]) * 0.000000001 > peak_hold_duration) {
+            display_peak_hold[c] = current_peak[c];
+            display_peak_hold_last_update_time[c] = ts;
+        }
+
+        if (current_input_peak[c] >= display_input_peak_hold[c] || !std::isfinite(display_input_peak_hold[c])) {
+            display_input_peak_hold[c] = current_input_peak[c];
+            display_input_peak_hold_last_update_time[c] = ts;
+        } else if ((ts - display_input_peak_hold_last_update_time[c]) * 0.000000001 > input_peak_hold_duration) {
+            display_input_peak_hold[c] = current_input_peak[c];
+            display_input_peak_hold_last_update_time[c] = ts;
+        }
+
+        if (!std::isfinite(display_magnitude[c])) {
+            display_magnitude[c] = current_magnitude[c];
+        } else {
+            float attack = float((current_magnitude[c] - display_magnitude[c]) * (time_since_last_redraw / magnitude_integration_time) * 0.99);
+            display_magnitude[c] = CLAMP(display_magnitude[c] + attack, (float)minimum_level, 0);
+        }
+    }
+
+    void CalculateBallistics(uint64_t ts, double time_since_last_redraw = 0.0)
+    {
+        std::lock_guard<std::mutex> lock(data_mutex);
+        for (int c = 0; c < MAX_AUDIO_CHANNELS; c++)
+            CalculateBallisticsForChannel(c, ts, time_since_last_redraw);
+    }
+};
+
+// Levels in dBFS, the same sequence is fed to both paths
+static std::vector<float> MakeLevels(size_t count)
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> dist(-70.f, 0.f);
+    std::vector<float> levels(count);
+    for (auto& l : levels)
+        l = dist(rng);
+    return levels;
+}
+
+// Nanoseconds per rendered frame for the whole layout
+static double RunLegacy(int meters, int frames, std::vector<float> const& levels)
+{
+    std::vector<LegacyMeter> bank(meters);
+    uint64_t ts = 0, next_callback = 0, last_redraw = 0;
+    size_t n = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) {
+        ts += FRAME_NS;
+        for (; next_callback <= ts; next_callback += CALLBACK_NS) {
+            for (auto& m : bank) {
+                {
+                    std::lock_guard<std::mutex> lock(m.data_mutex);
+                    for (int c = 0; c < MAX_AUDIO_CHANNELS; c++) {
+                        float level = c < CHANNELS ? levels[n++ % levels.size()] : -M_INFINITE;
+                        m.current_magnitude[c] = level - 6.f;
+                        m.current_peak[c] = level;
+                        m.current_input_peak[c] = level;
+                    }
+                }
+                m.CalculateBallistics(next_callback);
+            }
+        }
+        double dt = (ts - last_redraw) * 0.000000001;
+        for (auto& m : bank)
+            m.CalculateBallistics(ts, dt);
+        last_redraw = ts;
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / frames;
+}
+
+static double RunBank(int meters, int frames, std::vector<float> const& levels)
+{
+    MeterBank bank;
+    MeterBank::Params params { -60.f, 11.76f, 0.3f, 20.f, 1.f };
+    std::vector<int> lanes;
+    for (int i = 0; i < meters * CHANNELS; i++)
+        lanes.emplace_back(bank.Allocate(params));
+
+    uint64_t ts = 0, next_callback = 0;
+    size_t n = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) {
+        ts += FRAME_NS;
+        // Callbacks only record levels, the render thread reads the latest once per frame
+        bool updated = false;
+        for (; next_callback <= ts; next_callback += CALLBACK_NS)
+            updated = true;
+        if (updated) {
+            for (int lane : lanes) {
+                float level = levels[n++ % levels.size()];
+                bank.SetLevels(lane, level - 6.f, level, level);
+            }
+        }
+        bank.Step(ts);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / frames;
+}
+
+// Random lanes including the non-finite states the kernel has to pass through like the reference
+static MeterBank::Lanes MakeLanes(size_t count, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> level(-90.f, 0.f), age(0.f, 25.f);
+    std::uniform_int_distribution<int> special(0, 9);
+    auto value = [&]() {
+        switch (special(rng)) {
+        case 0:
+            return -M_INFINITE;
+        case 1:
+            return -INFINITY;
+        case 2:
+            return NAN;
+        default:
+            return level(rng);
+        }
+    };
+
+    MeterBank::Lanes l;
+    l.Resize(count);
+    for (size_t i = 0; i < count; i++) {
+        l.current_peak[i] = value();
+        l.current_input_peak[i] = value();
+        l.current_magnitude[i] = value();
+        l.peak[i] = value();
+        l.peak_hold[i] = value();
+        l.peak_hold_age[i] = age(rng);
+        l.input_peak_hold[i] = value();
+        l.input_peak_hold_age[i] = age(rng);
+        l.magnitude[i] = value();
+        l.minimum_level[i] = -60.f;
+        l.peak_decay_rate[i] = 11.76f;
+        l.magnitude_integration_time[i] = 0.3f;
+        l.peak_hold_duration[i] = 20.f;
+        l.input_peak_hold_duration[i] = 1.f;
+    }
+    return l;
+}
+
+static bool Equal(MeterBank::Lanes const& a, MeterBank::Lanes const& b)
+{
+    auto same = [&](std::vector<float> const& x, std::vector<float> const& y) {
+        return memcmp(x.data(), y.data(), x.size() * sizeof(float)) == 0;
+    };
+    return same(a.peak, b.peak) && same(a.peak_hold, b.peak_hold) && same(a.peak_hold_age, b.peak_hold_age)
+        && same(a.input_peak_hold, b.input_peak_hold) && same(a.input_peak_hold_age, b.input_peak_hold_age)
+        && same(a.magnitude, b.magnitude);
+}
+
+// Steps random lanes with both kernels and compares every field after each step
+static bool CheckSimd(int steps)
+{
+    std::mt19937 rng(5678);
+    std::uniform_real_distribution<float> dt(0.f, 0.1f);
+    auto simd = MakeLanes(256, rng);
+    auto scalar = simd;
+
+    for (int i = 0; i < steps; i++) {
+        // New levels every few steps, so decay and hold timeouts get exercised as well
+        if (i % 4 == 0) {
+            auto fresh = MakeLanes(simd.Size(), rng);
+            simd.current_peak = scalar.current_peak = fresh.current_peak;
+            simd.current_input_peak = scalar.current_input_peak = fresh.current_input_peak;
+            simd.current_magnitude = scalar.current_magnitude = fresh.current_magnitude;
+        }
+        float d = dt(rng);
+        MeterBank::StepSimd(simd, simd.Size(), d);
+        MeterBank::StepScalar(scalar, 0, scalar.Size(), d);
+        if (!Equal(simd, scalar)) {
+            printf("SIMD ballistics diverged from the scalar reference at step %d\n", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+static double TimeKernel(void (*step)(MeterBank::Lanes&, size_t, float), size_t lanes, int frames)
+{
+    std::mt19937 rng(91011);
+    auto l = MakeLanes(lanes, rng);
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++)
+        step(l, l.Size(), 0.016f);
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / frames;
+}
+
+int main(int argc, char** argv)
+{
+    int frames = argc > 1 ? std::max(1, atoi(argv[1])) : 20000;
+    auto levels = MakeLevels(4096);
+
+    bool ok = CheckSimd(2000);
+    printf("SIMD kernel against scalar reference: %s\n", ok ? "ok" : "FAILED");
+
+    printf("%d channels per meter, %d frames\n", CHANNELS, frames);
+    for (int meters : { 1, 8, 32, 128 }) {
+        double legacy = RunLegacy(meters, frames, levels);
+        double bank = RunBank(meters, frames, levels);
+        printf("%4d meters: %10.1f ns per frame before, %10.1f ns after (%.1fx)\n", meters, legacy, bank, legacy / bank);
+    }
+
+    auto scalar = [](MeterBank::Lanes& l, size_t end, float dt) { MeterBank::StepScalar(l, 0, end, dt); };
+    for (size_t lanes : { 16, 64, 256 }) {
+        double s = TimeKernel(scalar, lanes, frames);
+        double v = TimeKernel(MeterBank::StepSimd, lanes, frames);
+        printf("%4zu lanes: %10.1f ns per step scalar, %10.1f ns SIMD (%.1fx)\n", lanes, s, v, s / v);
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
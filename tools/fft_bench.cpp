@@ -0,0 +1,70 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+
+// Checks the spectrum analyzer FFT against the reference DFT and times it.
+// Exits with a non-zero status if any size is off by more than the tolerance:
+//   fft_bench [iterations]
+#include "../src/util/fft.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <graphics/math-defs.h>
+#include <random>
+#include <vector>
+
+// Relative to the largest bin, float accumulation over log2(n) stages
+#define TOLERANCE 1e-5
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? std::max(1, atoi(argv[1])) : 2000;
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+    bool ok = true;
+
+    for (uint32_t size = 16; size <= 16384; size *= 2) {
+        Fft fft(size);
+        std::vector<float> input(size), window(size), fast(fft.Bins()), reference(fft.Bins());
+        for (uint32_t i = 0; i < size; i++) {
+            input[i] = dist(rng);
+            window[i] = float(0.5 - 0.5 * cos(2 * M_PI * i / size));
+        }
+
+        fft.Power(input.data(), window.data(), fast.data());
+        Fft::ReferencePower(input.data(), window.data(), size, reference.data());
+        double error = 0, largest = 0;
+        for (uint32_t k = 0; k < fft.Bins(); k++) {
+            error = std::max(error, double(fabsf(fast[k] - reference[k])));
+            largest = std::max(largest, double(reference[k]));
+        }
+        error /= largest;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+            fft.Power(input.data(), window.data(), fast.data());
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+        bool pass = error < TOLERANCE;
+        ok &= pass;
+        printf("%6u: %9.2f us per transform, relative error %.2e %s\n", size, elapsed.count() / iterations, error,
+            pass ? "ok" : "FAILED");
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,169 @@
+/*************************************************************************
+ * This file is part of durchblick
+ * git.vrsal.xyz/alex/durchblick
+ * Copyright 2023 univrsal <uni@vrsal.xyz>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************/
+
+// Reference reader for the shared memory output, see src/util/shm_frame.hpp.
+// Prints one line per frame it managed to read and optionally writes the last
+// one to a file, e.g. for a BGRA 1920x1080 segment:
+//   shm_reader /durchblick-main 100 frame.raw
+//   ffplay -f rawvideo -pixel_format bgra -video_size 1920x1080 frame.raw
+#include "../src/util/shm_frame.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+struct Segment {
+    int fd { -1 };
+    uint8_t const* map {};
+    size_t size {};
+
+    ShmFrame::Header const* Header() const { return reinterpret_cast<ShmFrame::Header const*>(map); }
+
+    bool Open(char const* name)
+    {
+        fd = shm_open(name, O_RDONLY, 0);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(ShmFrame::Header)) {
+            Close();
+            return false;
+        }
+        size = size_t(st.st_size);
+        void* m = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (m == MAP_FAILED) {
+            Close();
+            return false;
+        }
+        map = static_cast<uint8_t const*>(m);
+
+        // Pairs with the release store of the producer, the rest of the header is valid after it
+        auto const* h = Header();
+        if (h->magic.load(std::memory_order_acquire) != ShmFrame::MAGIC || h->version != ShmFrame::VERSION
+            || ShmFrame::SegmentSize(h->frame_size) > size) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close()
+    {
+        if (map)
+            munmap(const_cast<uint8_t*>(map), size);
+        if (fd >= 0)
+            close(fd);
+        fd = -1;
+        map = nullptr;
+        size = 0;
+    }
+
+    // Copies the newest complete frame, returns false if there is none or the producer kept overwriting it
+    bool ReadLatest(std::vector<uint8_t>& out, uint64_t& frame, uint64_t& timestamp) const
+    {
+        auto const* h = Header();
+        for (int attempt = 0; attempt < 3; attempt++) {
+            uint64_t frames = h->frames.load(std::memory_order_acquire);
+            if (frames == 0)
+                return false;
+            uint64_t n = frames - 1;
+            auto const& slot = h->slots[n % ShmFrame::SLOTS];
+
+            if (slot.seq.load(std::memory_order_acquire) != 2 * n + 2)
+                continue;
+            out.resize(h->frame_size);
+            memcpy(out.data(), map + slot.offset, h->frame_size);
+            timestamp = slot.timestamp;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == 2 * n + 2) {
+                frame = n;
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <segment name> [frame count] [output file]\n", argv[0]);
+        return 1;
+    }
+    char const* name = argv[1];
+    long count = argc > 2 ? strtol(argv[2], nullptr, 10) : 0;
+    char const* output = argc > 3 ? argv[3] : nullptr;
+
+    Segment segment;
+    std::vector<uint8_t> frame;
+    uint64_t last = UINT64_MAX, n = 0, ts = 0, torn = 0;
+    long read = 0;
+
+    while (count <= 0 || read < count) {
+        if (!segment.map || segment.Header()->closed.load(std::memory_order_acquire)) {
+            // The producer isn't running yet or started a new segment for a different resolution
+            segment.Close();
+            if (!segment.Open(name)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            auto const* h = segment.Header();
+            printf("Opened '%s': %ux%u %s, %u bytes per frame\n", name, h->width, h->height,
+                h->format == ShmFrame::NV12 ? "NV12" : "BGRA", h->frame_size);
+            last = UINT64_MAX;
+        }
+
+        if (!segment.ReadLatest(frame, n, ts)) {
+            torn++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            continue;
+        }
+        if (n == last) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            continue;
+        }
+
+        uint32_t checksum = 0;
+        for (size_t i = 0; i < frame.size(); i += 64)
+            checksum = checksum * 31 + frame[i];
+        printf("frame %llu%s ts %llu checksum %08x\n", (unsigned long long)n,
+            last != UINT64_MAX && n != last + 1 ? " (skipped some)" : "", (unsigned long long)ts, checksum);
+        last = n;
+        read++;
+    }
+
+    if (output && !frame.empty()) {
+        FILE* f = fopen(output, "wb");
+        if (!f || fwrite(frame.data(), 1, frame.size(), f) != frame.size()) {
+            fprintf(stderr, "Couldn't write '%s'\n", output);
+            if (f)
+                fclose(f);
+            return 1;
+        }
+        fclose(f);
+    }
+    printf("Read %ld frames, %llu attempts found no new complete frame\n", read, (unsigned long long)torn);
+    segment.Close();
+    return 0;
+}